@@ -1,5 +1,6 @@
 #include "TMS57070.h"
 #include <cassert>
+#include <cstring>
 
 using namespace TMS57070;
 
@@ -13,6 +14,13 @@ void Emulator::reset() {
 	CR1.value = 0x810100;
 	CR2.value = 0x30FF00;
 	CR3.value = 0xE50000;
+
+	cycle = 0;
+	faulted = false;
+	start_sample_clocks();
+	events.clear();
+	next_event_cycle = UINT64_MAX;
+	irq_poll = true;
 	
 	addr_regs_pipeline.dual_ptr = nullptr;
 	addr_regs_pipeline.single_ptr = nullptr;
@@ -21,20 +29,49 @@ void Emulator::reset() {
 }
 
 void Emulator::step() {
+	if (cycle >= next_event_cycle) {
+		handle_events();
+	}
+	if (core == CoreKind::Lean) {
+		if (observing()) {
+			clock_cycle<LeanCore<true>>();
+		} else {
+			clock_cycle<LeanCore<false>>();
+		}
+	} else {
+		if (observing()) {
+			clock_cycle<StrictCore<true>>();
+		} else {
+			clock_cycle<StrictCore<false>>();
+		}
+	}
+}
+
+template <class Core>
+void Emulator::clock_cycle() {
 	/* Tasks:
 	Read PMEM at PC
 	inc PC
 	decode & execute
 	*/
 
+	uint16_t fetch_pc = PC.value;
+	if (Core::OBSERVED && debugger && debugger->break_at(fetch_pc) && stop_at_breakpoint()) {
+		return; //Stop before the instruction
+	}
+
 	insn = PMEM[PC.value];
 	tms_printf("Read instruction %08X from %03X\n", insn, PC.value);
+	Core::Hooks::fetch(*this, PC.value, insn);
 
 	if (RPTC) { //Are we in a repeat?
 		if (PC.value == rep_end_PC.value) {
 			tms_printf("PC matched repeat end: %X. Setting PC back to %X\n", rep_end_PC.value, rep_start_PC.value);
 			PC.value = rep_start_PC.value;
 			RPTC--;
+			if (!RPTC) {
+				Core::Hooks::repeat_end(*this, PC.value);
+			}
 		} else {
 			PC.value++;
 		}
@@ -45,15 +82,15 @@ void Emulator::step() {
 	addr_regs_pipeline_step();
 
 	if ((insn >> 24) >= 0xC0) { //Only primary instruction
-		execPrimary();
+		execPrimary<Core>();
 	} else if ((insn >> 24) >= 0x80) { //Class 2 instruction
-		execClass2();
-		execPrimary();
-		execPostIncrements();
+		execClass2<Core>();
+		execPrimary<Core>();
+		execPostIncrements<Core>();
 	} else { //Class 1 instruction
-		execSecondary();
-		execPrimary();
-		execPostIncrements();
+		execSecondary<Core>();
+		execPrimary<Core>();
+		execPostIncrements<Core>();
 	}
 
 	//Apply MACC pipeline
@@ -62,20 +99,25 @@ void Emulator::step() {
 	MACC1_delayed1.set(MACC1);
 	MACC2_delayed1.set(MACC2);
 
-	//Handle background XMEM reading
-	if (XMEM_read_cycles != 0) {
-		XMEM_read_cycles--;
-		if (XMEM_read_cycles == 0) {
-			//Read is done
-			XRD.value = XMEM[XMEM_read_addr].value;
-			if (!CR3.XWORD) {
-				XRD.value &= 0xFFFF00; //16-bit truncation
-			}
-			tms_printf("External read complete. addr=%06X data=%06X\n", XMEM_read_addr, XRD.value);
-		}
+	if (irq_poll) {
+		check_interrupts();
+	}
+
+	Core::Hooks::instruction_end(*this, fetch_pc);
+	cycle++;
+
+	//Events due at the next cycle land at the end of this one, so that state read between step() calls
+	//already shows them (XRD of a background read is written in the cycle before the read completes)
+	if (cycle >= next_event_cycle) {
+		handle_events();
 	}
+}
+
+//Checks if there is an interrupt to jump to. Only needed after CR2 changes.
+//Rare enough that its observers are checked at runtime, like the sample in/out hooks
+void Emulator::check_interrupts() {
+	irq_poll = false;
 
-	//Check if there is an interrupt to jump to
 	//Are we FREE?
 	if (CR2.FREE) {
 		//AND interrupt flags and enables
@@ -83,7 +125,10 @@ void Emulator::step() {
 		uint8_t pending_interrupts = CR2.bytes[0]/*flags*/ & ~CR2.bytes[1]/*enables*/;
 		if (pending_interrupts) {
 			//There is an interrupt to jump to
-			assert(SP != 4); //Stack overflow!
+			if (SP == 4) { //Stack overflow!
+				fault();
+				return;
+			}
 			stack[SP].value = PC.value;
 			SP++;
 			CR2.FREE = 0;
@@ -91,12 +136,176 @@ void Emulator::step() {
 			interrupt_vector_t vector = int_vector_decode(pending_interrupts);
 			PC.value = vector.PC.value; //Set PC
 			CR2.bytes[0] &= ~vector.flag; //Clear flag
+			if (profiler) {
+				profiler->interrupt(vector.PC.value);
+			}
+			if (hooks) {
+				hooks->interrupt_enter(cycle, vector.PC.value, stack[SP - 1].value);
+			}
+			if (headroom) {
+				headroom->interrupt(cycle, vector.PC.value);
+			}
 
 			tms_printf("Interrupted! Going to PC %08X\n", PC.value);
 		}
 	}
 }
 
+//Handles all events that are due at the current cycle
+void Emulator::handle_events() {
+	while (!events.empty() && events.top().cycle <= cycle) {
+		event_t event = events.top();
+		events.pop();
+
+		switch (event.type) {
+		case EventType::XMEMRead:
+			//Background read is done
+			XRD.value = XMEM.read(event.addr);
+			if (!CR3.XWORD) {
+				XRD.value &= 0xFFFF00; //16-bit truncation
+			}
+			tms_printf("External read complete. addr=%06X data=%06X\n", event.addr, XRD.value);
+			break;
+		case EventType::XMEMWrite:
+			xmemWrite<StrictCore<true>>(event.addr, event.value); //Outside of any instruction, so check every hook
+			tms_printf("External write complete. addr=%06X data=%06X\n", event.addr, event.value);
+			break;
+		case EventType::SampleIn:
+			sample_in((Channel)event.arg, event.value);
+			break;
+		case EventType::ExtInterrupt:
+			ext_interrupt(event.arg);
+			break;
+		case EventType::HIRInterrupt:
+			hir_interrupt(uint24_t{ (uint32_t)event.value });
+			break;
+		}
+	}
+	next_event_cycle = events.next_cycle();
+}
+
+void Emulator::schedule(event_t event) {
+	events.push(event);
+	next_event_cycle = events.next_cycle();
+}
+
+void Emulator::cancel(EventType type) {
+	events.remove(type);
+	next_event_cycle = events.next_cycle();
+}
+
+void Emulator::schedule_sample_in(uint64_t at_cycle, Channel channel, int32_t value) {
+	schedule(event_t{ at_cycle, 0, EventType::SampleIn, (uint8_t)channel, 0, value });
+}
+
+void Emulator::schedule_ext_interrupt(uint64_t at_cycle, uint8_t interrupt) {
+	schedule(event_t{ at_cycle, 0, EventType::ExtInterrupt, interrupt, 0, 0 });
+}
+
+void Emulator::schedule_hir_interrupt(uint64_t at_cycle, uint24_t input) {
+	schedule(event_t{ at_cycle, 0, EventType::HIRInterrupt, 0, 0, (int32_t)input.value });
+}
+
+void Emulator::run(uint64_t cycles) {
+	run_until(cycle + cycles);
+}
+
+void Emulator::run_until(uint64_t target_cycle) {
+	if (debug_stopped()) {
+		return;
+	}
+	if (cycle >= next_event_cycle) {
+		handle_events(); //Scheduled by the host for a cycle already reached
+	}
+	run_straight(target_cycle);
+}
+
+//Straight-line execution up to target_cycle. clock_cycle() handles the events that fall due on the way
+template <class Core>
+bool Emulator::run_straight(uint64_t target_cycle) {
+	while (cycle < target_cycle) {
+		clock_cycle<Core>();
+		if (Core::OBSERVED && debug_stopped()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Emulator::run_straight(uint64_t target_cycle) {
+	if (core == CoreKind::Lean) {
+		return observing() ? run_straight<LeanCore<true>>(target_cycle) : run_straight<LeanCore<false>>(target_cycle);
+	}
+	return observing() ? run_straight<StrictCore<true>>(target_cycle) : run_straight<StrictCore<false>>(target_cycle);
+}
+
+void Emulator::run_sample_period(AudioPort port) {
+	SampleClock* sample_clock = (port == AudioPort::ARI1) ? &ari1_clock : &ari2_clock;
+	run_until(sample_clock->next_cycle());
+	if (debug_stopped()) {
+		return; //The period is not over
+	}
+	sample_clock->advance();
+	if (digest || columns) {
+		uint32_t values[TRACE_REG_COUNT];
+		register_values(values);
+		if (digest) {
+			digest->sample(cycle, values, PC.value);
+		}
+		if (columns) {
+			columns->sample(values);
+		}
+	}
+	if (probes) {
+		capture_probes();
+	}
+	if (heatmap) {
+		heatmap->sample();
+	}
+}
+
+void Emulator::run_block(AudioPort port, audio_block_t& block) {
+	Channel in_L = (port == AudioPort::ARI1) ? Channel::in_1L : Channel::in_2L;
+	Channel in_R = (port == AudioPort::ARI1) ? Channel::in_1R : Channel::in_2R;
+
+	active_block = &block;
+	for (block_frame = 0; block_frame < block.frames; block_frame++) {
+		if (block.in_L) {
+			sample_in(in_L, block.in_L[block_frame]);
+		}
+		if (block.in_R) {
+			sample_in(in_R, block.in_R[block_frame]);
+		}
+		run_sample_period(port);
+		if (debug_stopped()) {
+			block.frames = block_frame; //Frames that completed
+			break;
+		}
+	}
+	active_block = nullptr;
+}
+
+uint64_t Emulator::next_sample_cycle(AudioPort port) {
+	if (port == AudioPort::ARI1) {
+		return ari1_clock.next_cycle();
+	}
+	return ari2_clock.next_cycle();
+}
+
+void Emulator::set_clock(clock_config_t config) {
+	clock = config;
+	ari1_clock.configure(clock.dsp_clock_hz, clock.ari1_sample_rate);
+	ari2_clock.configure(clock.dsp_clock_hz, clock.ari2_sample_rate);
+	if (headroom) {
+		set_headroom_meter(headroom); //Update the budget
+	}
+}
+
+void Emulator::start_sample_clocks() {
+	ari1_clock.start(cycle);
+	ari2_clock.start(cycle);
+}
+
 //Decodes an interrupt flag/enable value to an interrupt vector location
 interrupt_vector_t Emulator::int_vector_decode(uint8_t flags) {
 	//This mask, once applied, will select the least-significant '1' bit in the input number
@@ -144,6 +353,16 @@ void Emulator::addr_regs_pipeline_step() {
 }
 
 void Emulator::sample_in(Channel channel, int32_t value) {
+	if (input_recorder) {
+		input_recorder->record(cycle, StimulusType::SampleIn, (uint8_t)channel, value);
+	}
+	if (headroom && !CR2.FREE) {
+		headroom->sample_arrived((channel <= Channel::in_1R) ? AudioPort::ARI1 : AudioPort::ARI2);
+	}
+	if (hooks) {
+		hooks->sample_in(cycle, channel, value);
+	}
+
 	//Set input register and raise flag
 	switch (channel) {
 	case Channel::in_1L:
@@ -165,6 +384,29 @@ void Emulator::sample_in(Channel channel, int32_t value) {
 	default:
 		assert(false); //Wrong channel
 	}
+	irq_poll = true;
+}
+
+//Delivers an audio output sample to the block being rendered and the callback
+void Emulator::sample_out(Channel channel, int32_t value) {
+	if (overflow) {
+		overflow->output((uint32_t)channel - (uint32_t)Channel::out_1L, value);
+	}
+	if (digest) {
+		digest->output((uint32_t)channel, value);
+	}
+	if (active_block) {
+		int32_t* buffer = active_block->out[(int)channel - (int)Channel::out_1L];
+		if (buffer) {
+			buffer[block_frame] = value;
+		}
+	}
+	if (hooks) {
+		hooks->sample_out(cycle, channel, value);
+	}
+	if (sample_out_cb) {
+		sample_out_cb(channel, value);
+	}
 }
 
 void Emulator::register_sample_out_callback(sample_out_callback_t cb) {
@@ -179,12 +421,19 @@ void Emulator::register_external_bus_out_callback(external_bus_out_callback_t cb
 }
 
 uint32_t Emulator::hir_out() {
+	if (input_recorder) {
+		input_recorder->record(cycle, StimulusType::HIROut, 0, 0);
+	}
 	uint32_t value = HIR.value;
 	HIR.value = 0;
 	return value;
 }
 
 void Emulator::ext_interrupt(uint8_t interrupt) {
+	if (input_recorder) {
+		input_recorder->record(cycle, StimulusType::ExtInterrupt, interrupt, 0);
+	}
+
 	CR2.INT2_IF;
 	switch (interrupt) {
 	case 1:
@@ -199,11 +448,40 @@ void Emulator::ext_interrupt(uint8_t interrupt) {
 	default:
 		assert(false); //Invalid external interrupt number
 	}
+	irq_poll = true;
 }
 
 void Emulator::hir_interrupt(uint24_t input) {
+	if (input_recorder) {
+		input_recorder->record(cycle, StimulusType::HIRInterrupt, 0, input.value);
+	}
+
 	CR2.HIR_IF = 1;
 	HIR.value = input.value;
+	irq_poll = true;
+}
+
+//Reads the external bus (ED## pins) into XRD
+void Emulator::ext_bus_read(uint32_t address) {
+	if (input_replayer) {
+		XRD.value = input_replayer->bus_in(cycle, address);
+	} else if (ext_bus_in_cb) {
+		XRD.value = ext_bus_in_cb(address);
+	} else {
+		return; //Nothing drives the bus
+	}
+
+	if (input_recorder) {
+		input_recorder->record_bus_in(cycle, address, XRD.value);
+	}
+}
+
+void Emulator::set_input_recorder(InputRecorder* recorder) {
+	input_recorder = recorder;
+}
+
+void Emulator::set_input_replayer(InputReplayer* replayer) {
+	input_replayer = replayer;
 }
 
 void Emulator::update_mac_modes() {
@@ -241,90 +519,269 @@ void Emulator::update_mac_modes() {
 	MACC2_delayed1.bit_count = bit_count;
 }
 
+//Called on unknown instructions and behaviour (see UNKNOWN_STRICT) and on stack errors
+void Emulator::fault() {
+	faulted = true;
+	if (fault_action == FaultAction::Assert) {
+		assert(false);
+	}
+}
+
+void Emulator::set_fault_action(FaultAction action) {
+	fault_action = action;
+}
+
+void Emulator::set_core(CoreKind kind) {
+	core = kind;
+}
+
+void Emulator::set_tracer(TraceRecorder* recorder) {
+	tracer = recorder;
+}
+
+//Reports the registers this cycle changed. Changes made by events between cycles show up with the next instruction
+void Emulator::trace_registers() {
+	//Many cycles (jumps, idle loops) change no registers at all: compare the raw register block first.
+	//SP to BIO are declared together, so they are laid out in order
+	const uint8_t* block_start = (const uint8_t*)&SP;
+	const uint8_t* block_end = (const uint8_t*)(&BIO + 1);
+	uint32_t control[4] = { CR0.value, CR1.value, CR2.value, CR3.value };
+	if (tracer->unchanged(block_start, block_end - block_start, control, sizeof(control))) {
+		return;
+	}
+
+	uint32_t values[TRACE_REG_COUNT];
+	register_values(values);
+	tracer->registers(cycle, values);
+}
+
+void Emulator::register_values(uint32_t values[TRACE_REG_COUNT]) {
+	const uint32_t registers[TRACE_REG_COUNT] = {
+		(uint32_t)ACC1.value & UINT24_MAX, (uint32_t)ACC2.value & UINT24_MAX,
+		(uint32_t)(MACC1.getRaw() >> 24) & 0xFFFFFFF, (uint32_t)MACC1.getRaw() & UINT24_MAX,
+		(uint32_t)(MACC2.getRaw() >> 24) & 0xFFFFFFF, (uint32_t)MACC2.getRaw() & UINT24_MAX,
+		(uint32_t)XRD.value & UINT24_MAX, (uint32_t)T.value & UINT24_MAX, HIR.value,
+		(uint32_t)AR1L.value & UINT24_MAX, (uint32_t)AR1R.value & UINT24_MAX, (uint32_t)AR2L.value & UINT24_MAX, (uint32_t)AR2R.value & UINT24_MAX,
+		(uint32_t)AX1L.value & UINT24_MAX, (uint32_t)AX1R.value & UINT24_MAX, (uint32_t)AX2L.value & UINT24_MAX,
+		(uint32_t)AX2R.value & UINT24_MAX, (uint32_t)AX3L.value & UINT24_MAX, (uint32_t)AX3R.value & UINT24_MAX,
+		(uint32_t)CA.two.value << 12 | CA.one.value, (uint32_t)DA.two.value << 12 | DA.one.value,
+		(uint32_t)CIR.two.value << 12 | CIR.one.value, (uint32_t)DIR.two.value << 12 | DIR.one.value,
+		COFF.value, CCIRC.value, DOFF.value, DCIRC.value, XOFF, GOFF.value,
+		CR0.value, CR1.value, CR2.value, CR3.value,
+		SP, RPTC,
+	};
+	memcpy(values, registers, sizeof(registers));
+}
+
+void Emulator::set_profiler(Profiler* profile) {
+	profiler = profile;
+}
+
+void Emulator::set_overflow_counters(OverflowCounters* counters) {
+	overflow = counters;
+}
+
+void Emulator::set_coverage(Coverage* counters) {
+	coverage = counters;
+}
+
+void Emulator::set_headroom_meter(HeadroomMeter* meter) {
+	headroom = meter;
+	if (headroom) {
+		uint32_t rate = (headroom->audio_port() == AudioPort::ARI1) ? clock.ari1_sample_rate : clock.ari2_sample_rate;
+		headroom->set_budget((double)clock.dsp_clock_hz / rate);
+	}
+}
+
+void Emulator::set_debugger(Debugger* breakpoints) {
+	debugger = breakpoints;
+	access_observed = heatmap || debugger || hooks;
+}
+
+bool Emulator::stop_at_breakpoint() {
+	uint32_t values[TRACE_REG_COUNT];
+	register_values(values);
+	return debugger->breakpoint(PC.value, cycle, values);
+}
+
+void Emulator::set_heatmap(AccessHeatmap* map) {
+	heatmap = map;
+	access_observed = heatmap || debugger || hooks;
+}
+
+void Emulator::observe_access(TraceTarget target, uint32_t addr) {
+	if (heatmap) {
+		heatmap->access(target, addr);
+	}
+	if (debugger) {
+		debugger->access(target, addr);
+	}
+	if (hooks) {
+		hooks->access(cycle, target, addr);
+	}
+}
+
+void Emulator::observe_write(TraceTarget target, uint32_t addr, int32_t value) {
+	if (heatmap) {
+		heatmap->write(target, addr);
+	}
+	if (debugger) {
+		debugger->write(target, addr);
+	}
+	if (hooks) {
+		hooks->write(cycle, target, addr, value);
+	}
+}
+
+void Emulator::set_hooks(CoreHooks* core_hooks) {
+	hooks = core_hooks;
+	access_observed = heatmap || debugger || hooks;
+	if (hooks && hooks->register_writes) {
+		register_values(hook_registers);
+	}
+}
+
+void Emulator::hooked_instruction_end(uint16_t pc) {
+	if (hooks->register_writes) {
+		uint32_t values[TRACE_REG_COUNT];
+		register_values(values);
+		for (uint32_t reg = 0; reg < TRACE_REG_COUNT; reg++) {
+			if (values[reg] != hook_registers[reg]) {
+				hooks->register_write(cycle, (TraceReg)reg, values[reg]);
+				hook_registers[reg] = values[reg];
+			}
+		}
+	}
+	hooks->instruction_end(cycle, pc);
+}
+
+void Emulator::set_column_recorder(ColumnRecorder* recorder) {
+	columns = recorder;
+}
+
+void Emulator::set_probes(ProbeSet* probe_set) {
+	probes = probe_set;
+}
+
+void Emulator::capture_probes() {
+	uint32_t registers[TRACE_REG_COUNT];
+	if (probes->has_registers()) {
+		register_values(registers);
+	}
+	int32_t* frame = probes->next_frame();
+	for (size_t index = 0; index < probes->count(); index++) {
+		const probe_t& probe = probes->probe(index);
+		switch (probe.target) {
+		case TraceTarget::CMEM:
+			frame[index] = CMEM[probe.addr].value;
+			break;
+		case TraceTarget::DMEM:
+			frame[index] = DMEM[probe.addr].value;
+			break;
+		case TraceTarget::XMEM:
+			frame[index] = XMEM.read(probe.addr);
+			break;
+		default:
+			switch ((TraceReg)probe.addr) {
+			case TraceReg::MAC1:
+			case TraceReg::MAC2:
+				frame[index] = (int32_t)(registers[probe.addr] << 4) >> 4; //Sign-extend 28 bits
+				break;
+			case TraceReg::MAC1L:
+			case TraceReg::MAC2L:
+			case TraceReg::HIR:
+				frame[index] = (int32_t)registers[probe.addr];
+				break;
+			default:
+				//Data registers are signed, address and control registers are small enough to stay positive
+				frame[index] = (probe.addr <= (uint32_t)TraceReg::AX3R) ? (int32_t)(registers[probe.addr] << 8) >> 8 : (int32_t)registers[probe.addr];
+				break;
+			}
+			break;
+		}
+	}
+}
+
+void Emulator::set_dirty_tracker(DirtyTracker* tracker) {
+	dirty = tracker;
+}
+
+void Emulator::mark_xmem_dirty() {
+	for (uint32_t page_index = 0; page_index < XMEM.page_count(); page_index++) {
+		const int32_t* page = XMEM.page(page_index);
+		if (!page) {
+			continue;
+		}
+		for (uint32_t offset = 0; offset < PagedMemory::PAGE_WORDS; offset++) {
+			if (page[offset]) {
+				dirty->XMEM.mark(page_index * PagedMemory::PAGE_WORDS + offset);
+			}
+		}
+	}
+}
+
+void Emulator::set_digest(StateDigest* state_digest) {
+	digest = state_digest;
+	if (digest) {
+		digest->set_memory(memory_digest());
+	}
+}
+
+uint64_t Emulator::memory_digest() {
+	uint64_t hash = 0;
+	for (uint32_t addr = 0; addr < 512; addr++) {
+		hash ^= digest_word(TraceTarget::CMEM, addr, (uint32_t)CMEM[addr].value);
+		hash ^= digest_word(TraceTarget::DMEM, addr, (uint32_t)DMEM[addr].value);
+	}
+	for (uint32_t page_index = 0; page_index < XMEM.page_count(); page_index++) {
+		const int32_t* page = XMEM.page(page_index);
+		if (!page) {
+			continue;
+		}
+		for (uint32_t offset = 0; offset < PagedMemory::PAGE_WORDS; offset++) {
+			hash ^= digest_word(TraceTarget::XMEM, page_index * PagedMemory::PAGE_WORDS + offset, (uint32_t)page[offset]);
+		}
+	}
+	return hash;
+}
+
 void Emulator::set_bio(bool value) {
+	if (input_recorder) {
+		input_recorder->record(cycle, StimulusType::SetBIO, value, 0);
+	}
 	this->BIO = value;
 }
 
-static std::string jsonValue(const char* name, uint32_t value) {
-	std::string build;
-	constexpr int TEMP_LEN = 16;
+//Appends "name":{"address":"value",...} for the dirty words of one memory, and clears them
+template <typename Read>
+static void jsonChanges(std::string& report, const char* name, DirtyMap& map, Read read) {
+	constexpr int TEMP_LEN = 32;
 	char temp[TEMP_LEN];
-	
-	build.append("\"");
-	build.append(name);
-	build.append("\":\"");
-	snprintf(temp, TEMP_LEN, "%06lX", value);
-	int temp_pos = 0;
-	if (strlen(temp) > 6) {
-		temp_pos = (int)strlen(temp) - 6;
-	}
-	assert(strlen(temp + temp_pos) == 6); //Hex length is always 6
-	build.append(temp + temp_pos);
-	build.append("\",");
 
-	return build;
+	report.append("\"");
+	report.append(name);
+	report.append("\":{");
+	map.collect([&](uint32_t addr) {
+		snprintf(temp, TEMP_LEN, "\"%X\":\"%06X\",", addr, (uint32_t)read(addr) & UINT24_MAX);
+		report.append(temp);
+	});
+	if (report.back() == ',') {
+		report.pop_back(); //Delete last comma
+	}
+	report.append("}");
 }
 
-//Returns a JSON string with CMEM, DMEM, and all the registers
-std::string Emulator::reportState() {
+//Returns a JSON string with the CMEM, DMEM and XMEM words written since the previous call, keyed by hex address.
+//Cheap enough to call every sample: the cost follows the number of words written, not the memory sizes
+std::string Emulator::reportChanges() {
+	assert(dirty); //set_dirty_tracker() first
 	std::string report;
-	constexpr int TEMP_LEN = 16;
-	char temp[TEMP_LEN];
 	report.append("{");
-	
-	report.append(jsonValue("ACC1", ACC1.value));
-	report.append(jsonValue("ACC2", ACC2.value));
-	report.append(jsonValue("MAC1", MACC1.getUpper().value));
-	report.append(jsonValue("MAC2", MACC2.getUpper().value));
-	report.append(jsonValue("MAC1L", MACC1.getLower().value));
-	report.append(jsonValue("MAC2L", MACC2.getLower().value));
-	report.append(jsonValue("CA1", CA.one.value));
-	report.append(jsonValue("CA2", CA.two.value));
-	report.append(jsonValue("DA1", DA.one.value));
-	report.append(jsonValue("DA2", DA.two.value));
-	report.append(jsonValue("XRD", XRD.value));
-	report.append(jsonValue("CR0", CR0.value));
-	report.append(jsonValue("CR1", CR1.value));
-	report.append(jsonValue("CR2", CR2.value));
-	report.append(jsonValue("CR3", CR3.value));
-	report.append(jsonValue("CIR1", CIR.one.value));
-	report.append(jsonValue("CIR2", CIR.two.value));
-	report.append(jsonValue("DIR1", DIR.one.value));
-	report.append(jsonValue("DIR2", DIR.two.value));
-	
-	//report CMEM
-	report.append("\"CMEM\":[");
-	for (int i = 0; i < 255; i++) {
-		report.append("\"");
-		snprintf(temp, TEMP_LEN, "%06lX", CMEM[i].value);
-		int temp_pos = 0;
-		if (strlen(temp) > 6) {
-			temp_pos = (int)strlen(temp) - 6;
-		}
-		assert(strlen(temp + temp_pos) == 6); //Hex length is always 6
-		report.append(temp + temp_pos);
-		report.append("\",");
-	}
-	report.pop_back(); //Delete last comma
-	report.append("]");
+	jsonChanges(report, "CMEM", dirty->CMEM, [&](uint32_t addr) { return CMEM[addr].value; });
 	report.append(",");
-	
-	//report DMEM
-	report.append("\"DMEM\":[");
-	for (int i = 0; i < 255; i++) {
-		report.append("\"");
-		snprintf(temp, TEMP_LEN, "%06lX", DMEM[i].value);
-		int temp_pos = 0;
-		if (strlen(temp) > 6) {
-			temp_pos = (int)strlen(temp) - 6;
-		}
-		assert(strlen(temp + temp_pos) == 6); //Hex length is always 6
-		report.append(temp + temp_pos);
-		report.append("\",");
-	}
-	report.pop_back(); //Delete last comma
-	report.append("]");
-	
+	jsonChanges(report, "DMEM", dirty->DMEM, [&](uint32_t addr) { return DMEM[addr].value; });
+	report.append(",");
+	jsonChanges(report, "XMEM", dirty->XMEM, [&](uint32_t addr) { return XMEM.read(addr); });
 	report.append("}");
 	return report;
-}
\ No newline at end of file
+}
@@ -1,9 +1,28 @@
 #pragma once
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "TMS57070_MAC.h"
+#include "TMS57070_clock.h"
+#include "TMS57070_events.h"
+#include "TMS57070_replay.h"
+#include "TMS57070_memory.h"
+#include "TMS57070_trace.h"
+#include "TMS57070_digest.h"
+#include "TMS57070_dirty.h"
+#include "TMS57070_profile.h"
+#include "TMS57070_headroom.h"
+#include "TMS57070_coverage.h"
+#include "TMS57070_overflow.h"
+#include "TMS57070_probe.h"
+#include "TMS57070_heatmap.h"
+#include "TMS57070_columns.h"
+#include "TMS57070_debugger.h"
+#include "TMS57070_hooks.h"
 
 #define TMSDEBUG 0
 #if TMSDEBUG
@@ -18,10 +37,44 @@ constexpr int32_t INT24_MIN = -0x800000;
 
 namespace TMS57070 {
 
-    //Treat unknown instructions and behaviour as a fatal error
+    //Treat unknown instructions and behaviour as a fatal error in StrictCore
     //NDEBUG must not be defined for assert() to work
     constexpr bool UNKNOWN_STRICT = true;
 
+    //What the emulator does on a fault: unknown instructions and behaviour (see UNKNOWN_STRICT) or stack errors
+    enum class FaultAction {
+        Assert, //assert(false), stopping the process
+        Flag, //Set has_faulted() and carry on, for hosts that run many programs in one process
+    };
+
+    //Buffer sizes for Emulator::write_state_json() and write_state_binary()
+    constexpr size_t STATE_JSON_MAX = 12288;
+    constexpr size_t STATE_BINARY_SIZE = 20 + 4 * TRACE_REG_COUNT + 4 * 512 * 2;
+
+    //Land WRE writes after the same bus delay as RDE reads, instead of immediately.
+    //Unverified against hardware
+    constexpr bool XMEM_WRITE_DELAYED = false;
+
+    //Compile-time configuration of the execution core. The instruction, addressing and memory write functions are
+    //instantiated once per configuration, while the state layout stays the same, so one Emulator can switch between
+    //them at any instruction boundary (see Emulator::set_core()). Several configurations link into the same binary
+    template <bool strict, bool observed, bool xmem_write_delayed>
+    struct core_config_t {
+        static constexpr bool STRICT = strict; //Fault on unknown instructions and behaviour. Otherwise they are skipped
+        static constexpr bool OBSERVED = observed; //Call the hooks of the tracer, profiler, coverage counter, headroom meter, heatmap, debugger and CoreHooks
+        static constexpr bool XMEM_WRITE_DELAYED = xmem_write_delayed; //See XMEM_WRITE_DELAYED
+        using Hooks = typename std::conditional<observed, ObserverHooks, NoHooks>::type; //Static dispatch of the hook points (see TMS57070_hooks.h)
+    };
+
+    //The configurations set_core() chooses from. OBSERVED is chosen per run from the attached observers
+    template <bool observed> using StrictCore = core_config_t<UNKNOWN_STRICT, observed, XMEM_WRITE_DELAYED>;
+    template <bool observed> using LeanCore = core_config_t<false, observed, XMEM_WRITE_DELAYED>;
+
+    enum class CoreKind {
+        Strict, //StrictCore: unknown instructions and behaviour fault (see FaultAction). The default, for verification
+        Lean, //LeanCore: no checks for unknown behaviour, for production renders of programs known to be clean
+    };
+
     struct uint9_t {
         uint16_t value : 9;
     };
@@ -158,6 +211,14 @@ namespace TMS57070 {
         out_3R,
     };
 
+    //Audio buffers for Emulator::run_block(). Unused channels may be null
+    struct audio_block_t {
+        const int32_t* in_L; //Inputs of the audio port being run
+        const int32_t* in_R;
+        int32_t* out[6]; //Indexed from Channel::out_1L
+        uint32_t frames;
+    };
+
     using sample_out_callback_t = void(*)(Channel channel, int32_t value);
     using external_bus_in_callback_t = int32_t(*)(uint32_t address);
     using external_bus_out_callback_t = void(*)(int32_t value, uint32_t address);
@@ -186,8 +247,14 @@ namespace TMS57070 {
     };
 
     class Emulator {
+        friend struct ObserverHooks;
+        friend class ShadowRunner; //Compares the complete state of two emulators
+
     public:
+        Emulator() = default;
+        Emulator(const Emulator&) = delete; //Clone with fork(), which rebases the pointers into the instance
         void reset();
+        void clear(); //Back to a newly constructed Emulator after reset(): memories and registers zero, defaults, no observers or callbacks. Costs follow the XMEM pages in use
         void step(); //Clock the DSP
         void sample_in(Channel channel, int32_t value); //Provide audio input samples
         void register_sample_out_callback(sample_out_callback_t cb); //For receiving audio output samples
@@ -197,32 +264,142 @@ namespace TMS57070 {
         void hir_interrupt(uint24_t input); //Trigger Host Interface interrupt (opcode 0x10) 
         uint32_t hir_out(); //Read the Host Interface output register
         void set_bio(bool value);
+        static interrupt_vector_t int_vector_decode(uint8_t flags); //Vector of the highest priority interrupt among pending CR2 flags
         std::string reportState();
+        size_t write_state_json(char* buffer, size_t size); //reportState() without allocating. Returns the length, like snprintf()
+        bool write_state_json(FILE* out);
+        size_t write_state_binary(uint8_t* buffer, size_t size); //Same state in a fixed layout of STATE_BINARY_SIZE bytes
+        std::string reportChanges(); //Memory words written since the previous call. Needs a dirty tracker
+        void save_state(std::vector<uint8_t>& blob); //Serialize the complete emulator state into a versioned binary blob
+        bool load_state(const uint8_t* blob, size_t size); //Restore a save_state() blob. Returns false, with nothing changed, if it is invalid
+        void set_fault_action(FaultAction action);
+        void set_core(CoreKind kind); //Select the execution core. Takes effect at the next instruction
+        bool has_faulted() { return faulted; } //A fault happened since reset()
+        std::unique_ptr<Emulator> fork(); //Clone in constant time. XMEM is shared copy-on-write, recorders are not inherited
+
+        void set_clock(clock_config_t config); //Set instruction clock and audio port sample rates
+        void start_sample_clocks(); //Count sample periods of both ports from the current cycle
+        void run(uint64_t cycles); //Clock the DSP for a number of cycles
+        void run_until(uint64_t target_cycle); //Clock the DSP until the cycle counter reaches target_cycle
+        void run_sample_period(AudioPort port); //Clock the DSP until the next sample of this port is due
+        uint64_t next_sample_cycle(AudioPort port);
+        uint64_t cycles() { return cycle; } //Cycles executed since reset
+        void run_block(AudioPort port, audio_block_t& block); //Run one sample period per frame, feeding and capturing audio
+
+        //Timed stimuli, delivered when the cycle counter reaches at_cycle
+        void schedule_sample_in(uint64_t at_cycle, Channel channel, int32_t value);
+        void schedule_ext_interrupt(uint64_t at_cycle, uint8_t interrupt);
+        void schedule_hir_interrupt(uint64_t at_cycle, uint24_t input);
+
+        void set_input_recorder(InputRecorder* recorder); //Log all external stimuli from now on. Null to stop
+        void set_input_replayer(InputReplayer* replayer); //Take external bus input from a log instead of the callback
+        void set_tracer(TraceRecorder* recorder); //Trace every instruction and the writes it makes. Null to stop
+        void set_dirty_tracker(DirtyTracker* tracker); //Mark every CMEM/DMEM/XMEM word that is written. Null to stop
+        void set_profiler(Profiler* profile); //Count executions per PC, repeats, interrupts and idle time. Null to stop
+        void set_overflow_counters(OverflowCounters* counters); //Count saturation, overflow and output clipping events. Null to stop
+        void set_coverage(Coverage* counters); //Count executed opcodes, addressing and post-increment modes. Null to stop
+        void set_headroom_meter(HeadroomMeter* meter); //Measure the cycles the audio interrupt handler uses per sample period. Null to stop
+        void set_digest(StateDigest* state_digest); //Hash the state at the end of every run_sample_period(). Call again after writing memory directly. Null to stop
+        void set_debugger(Debugger* breakpoints); //Stop at breakpoints and watchpoints. Null to stop debugging
+        void set_heatmap(AccessHeatmap* map); //Count CMEM/DMEM/XMEM accesses per word at their effective addresses. Null to stop
+        void set_column_recorder(ColumnRecorder* recorder); //Append registers to a column file at the end of every run_sample_period(). Null to stop
+        void set_probes(ProbeSet* probe_set); //Capture the probed words and registers at the end of every run_sample_period(). Null to stop
+        void set_hooks(CoreHooks* core_hooks); //Call an instrumentation tool at the hook points of the core. Null to stop
 
     private:
-        void execPrimary();
-        void execSecondary();
-        void execClass2();
-        void execJmp();
-        void execPostIncrements();
-        interrupt_vector_t int_vector_decode(uint8_t);
-        uint32_t cmemAddressing();
-        uint32_t cmemAddressing(uint16_t addr);
-        uint32_t dmemAddressing();
-        uint32_t dmemAddressing(uint16_t addr);
-        uint32_t xmemAddressing(uint32_t addr);
-        int24_t* loadACCarith(ArithOperation operation);
-        int24_t* arith(ArithOperation operation);
+        Emulator& operator=(const Emulator&) = default; //For fork() only
+        template <class Core> void clock_cycle(); //Execute one cycle, then handle the events due at the next one. Core::OBSERVED: a tracer, profiler, coverage counter, headroom meter, heatmap, debugger or hooks are attached. A template argument so that it costs nothing when off
+        template <class Core> bool run_straight(uint64_t target_cycle); //clock_cycle() up to target_cycle. False if the debugger stopped
+        bool run_straight(uint64_t target_cycle); //Dispatch to the core and observation in use
+        bool observing() { return tracer || profiler || coverage || headroom || heatmap || debugger || hooks; }
+        bool debug_stopped() { return debugger && debugger->stopped(); }
+        bool stop_at_breakpoint(); //Evaluate the breakpoints at PC
+        void observe_access(TraceTarget target, uint32_t addr); //Effective address computed, for the heatmap, debugger and hooks
+        void observe_write(TraceTarget target, uint32_t addr, int32_t value);
+        void hooked_instruction_end(uint16_t pc); //Register writes and the end of the instruction, for the hooks
+        void handle_events();
+        void schedule(event_t event);
+        void cancel(EventType type);
+        void check_interrupts();
+        void sample_out(Channel channel, int32_t value);
+        void fault();
+        void trace_registers();
+        void register_values(uint32_t values[TRACE_REG_COUNT]); //Registers as traced and digested
+        void capture_probes();
+        uint64_t memory_digest(); //Full hash of the memories, see StateDigest
+        void mark_xmem_dirty(); //Mark every non-zero XMEM word, for changes that bypass xmemWrite()
+        void detach_observers(); //Null every recorder and observer, keeping the callbacks
+        //All CMEM/DMEM/XMEM writes go through these, so that they can be observed. The digest and dirty tracker
+        //are not hooks: they are cheap and stay checked in every core
+        template <class Core> void cmemWrite(uint32_t addr, int32_t value) {
+            if (digest) {
+                digest->write(TraceTarget::CMEM, addr, CMEM[addr].value, value);
+            }
+            CMEM[addr].value = value;
+            if (dirty) {
+                dirty->CMEM.mark(addr);
+            }
+            Core::Hooks::write(*this, TraceTarget::CMEM, addr, value);
+        }
+        template <class Core> void dmemWrite(uint32_t addr, int32_t value) {
+            if (digest) {
+                digest->write(TraceTarget::DMEM, addr, DMEM[addr].value, value);
+            }
+            DMEM[addr].value = value;
+            if (dirty) {
+                dirty->DMEM.mark(addr);
+            }
+            Core::Hooks::write(*this, TraceTarget::DMEM, addr, value);
+        }
+        template <class Core> void xmemWrite(uint32_t addr, int32_t value) {
+            if (digest) {
+                digest->write(TraceTarget::XMEM, addr, XMEM.read(addr), value);
+            }
+            XMEM.write(addr, value);
+            if (dirty) {
+                dirty->XMEM.mark(addr);
+            }
+            Core::Hooks::write(*this, TraceTarget::XMEM, addr, value);
+        }
+        //MAC::getUpper() of a value the instruction uses. Counts a clamp of the overflow limiter once per use,
+        //where state reports and traces read the MACs without counting
+        int24_t macUpper(MAC& mac) {
+            bool clamped = false;
+            int24_t upper = mac.getUpper(&clamped);
+            if (clamped && overflow) {
+                overflow->mac_clamped();
+            }
+            return upper;
+        }
+        void ext_bus_read(uint32_t address);
+        uint32_t xmem_access_cycles();
+        uint32_t xmem_mask();
+        template <class Core> void execPrimary(); //Instantiated in TMS57070_core.cpp for StrictCore and LeanCore
+        template <class Core> void execSecondary();
+        template <class Core> void execClass2();
+        template <class Core> void execJmp();
+        template <class Core> void execPostIncrements();
+        template <class Core> uint32_t cmemAddressing();
+        template <class Core> uint32_t cmemAddressing(uint16_t addr);
+        template <class Core> uint32_t dmemAddressing();
+        template <class Core> uint32_t dmemAddressing(uint16_t addr);
+        template <class Core> uint32_t xmemAddressing(uint32_t addr);
+        template <class Core> int24_t* loadACCarith(ArithOperation operation);
+        template <class Core> int24_t* arith(ArithOperation operation);
         int32_t processACCValue(int32_t acc);
         void update_mac_modes();
         void addr_regs_pipeline_step();
+        uint8_t dual_reg_id(addr_reg_t* reg);
+        addr_reg_t* dual_reg_from_id(uint8_t id);
+        uint8_t single_reg_id(uint12_t* reg);
+        uint12_t* single_reg_from_id(uint8_t id);
 
     public:
         uint32_t PMEM[512];
         int24_t CMEM[512];
         int24_t DMEM[512];
         int24_t GMEM[256];
-        int24_t XMEM[0xFFFFFF]; //This is the largest possible XMEM configuration
+        PagedMemory XMEM{ 0xFFFFFF }; //This is the largest possible XMEM configuration
 
         cr0_t CR0;
         cr1_t CR1;
@@ -280,6 +457,40 @@ namespace TMS57070 {
 
     private: //Non-register variables
         uint32_t insn; //Current instruction
+        uint64_t cycle = 0;
+
+        clock_config_t clock{ DEFAULT_DSP_CLOCK_HZ, DEFAULT_SAMPLE_RATE, DEFAULT_SAMPLE_RATE };
+        SampleClock ari1_clock;
+        SampleClock ari2_clock;
+
+        EventQueue events;
+        uint64_t next_event_cycle = UINT64_MAX; //Cached events.next_cycle()
+        bool irq_poll = true; //CR2 or FREE changed, so pending interrupts must be re-evaluated
+
+        audio_block_t* active_block = nullptr; //Block being rendered by run_block()
+        uint32_t block_frame = 0;
+
+        FaultAction fault_action = FaultAction::Assert;
+        CoreKind core = CoreKind::Strict;
+        bool faulted = false;
+
+        InputRecorder* input_recorder = nullptr;
+        InputReplayer* input_replayer = nullptr;
+        TraceRecorder* tracer = nullptr;
+        StateDigest* digest = nullptr;
+        Profiler* profiler = nullptr;
+        HeadroomMeter* headroom = nullptr;
+        Coverage* coverage = nullptr;
+        OverflowCounters* overflow = nullptr;
+        ProbeSet* probes = nullptr;
+        AccessHeatmap* heatmap = nullptr;
+        ColumnRecorder* columns = nullptr;
+        Debugger* debugger = nullptr;
+        CoreHooks* hooks = nullptr;
+        uint32_t hook_registers[TRACE_REG_COUNT]; //Register values after the previous instruction, for CoreHooks::register_write()
+        bool access_observed = false; //A heatmap, debugger or hooks are attached. One flag, so that the addressing functions test once
+        DirtyTracker* dirty = nullptr;
+
         sample_out_callback_t sample_out_cb = nullptr;
         external_bus_in_callback_t ext_bus_in_cb = nullptr;
         external_bus_out_callback_t ext_bus_out_cb = nullptr;
@@ -299,9 +510,6 @@ namespace TMS57070 {
         MAC MACC1_delayed2{ this };
         MAC MACC2_delayed2{ this };
 
-        uint32_t XMEM_read_addr;
-        uint32_t XMEM_read_cycles;
-
         //Addressing regs pipeline
         struct {
             addr_reg_t* dual_ptr;
@@ -316,4 +524,77 @@ namespace TMS57070 {
         } addr_regs_pipeline;
     };
 
+    //Hook policy of the observed cores: the built-in observers, then the attached CoreHooks
+    struct ObserverHooks {
+        static void fetch(Emulator& emulator, uint16_t pc, uint32_t insn) {
+            if (emulator.tracer) {
+                emulator.tracer->record(emulator.cycle, TraceTarget::Instruction, pc, insn);
+            }
+            if (emulator.profiler) {
+                emulator.profiler->fetch(pc, emulator.SP, emulator.RPTC != 0);
+            }
+            if (emulator.coverage) {
+                emulator.coverage->count(insn);
+            }
+            if (emulator.heatmap) {
+                emulator.heatmap->fetch(pc);
+            }
+            if (emulator.hooks) {
+                emulator.hooks->fetch(emulator.cycle, pc, insn);
+            }
+        }
+        static void access(Emulator& emulator, TraceTarget target, uint32_t addr) {
+            if (emulator.access_observed) {
+                emulator.observe_access(target, addr);
+            }
+        }
+        static void write(Emulator& emulator, TraceTarget target, uint32_t addr, int32_t value) {
+            if (emulator.access_observed) {
+                emulator.observe_write(target, addr, value);
+            }
+            if (emulator.tracer) {
+                emulator.tracer->record(emulator.cycle, target, addr, (uint32_t)value & UINT24_MAX);
+            }
+        }
+        static void instruction_end(Emulator& emulator, uint16_t pc) {
+            if (emulator.tracer) {
+                emulator.trace_registers();
+            }
+            if (emulator.debugger) {
+                emulator.debugger->end_instruction(pc, emulator.cycle);
+            }
+            if (emulator.hooks) {
+                emulator.hooked_instruction_end(pc);
+            }
+        }
+        static void interrupt_exit(Emulator& emulator, uint16_t return_pc) {
+            if (emulator.headroom) {
+                emulator.headroom->handler_done(emulator.cycle);
+            }
+            if (emulator.hooks) {
+                emulator.hooks->interrupt_exit(emulator.cycle, return_pc);
+            }
+        }
+        static void repeat_start(Emulator& emulator, uint16_t start_pc, uint16_t end_pc, uint32_t count) {
+            if (emulator.hooks) {
+                emulator.hooks->repeat_start(emulator.cycle, start_pc, end_pc, count);
+            }
+        }
+        static void repeat_end(Emulator& emulator, uint16_t pc) {
+            if (emulator.hooks) {
+                emulator.hooks->repeat_end(emulator.cycle, pc);
+            }
+        }
+        static void branch(Emulator& emulator, uint16_t target) { //Taken jump, not a call. PC is past the jump
+            if (emulator.headroom && (target & 0x1FF) == ((emulator.PC.value - 1) & 0x1FF)) {
+                emulator.headroom->handler_done(emulator.cycle); //Reached an idle loop
+            }
+        }
+        static void circular(Emulator& emulator, TraceTarget target, uint32_t start, uint32_t length) { //0x27 moved the offset of a memory
+            if (emulator.heatmap) {
+                emulator.heatmap->circular(target, start, length);
+            }
+        }
+    };
+
 }
\ No newline at end of file
@@ -14,7 +14,14 @@ MAC::MAC(Emulator* dsp) {
 	value.raw = 0;
 }
 
-int24_t MAC::getUpper() {
+MAC& MAC::operator=(const MAC& mac) {
+	value = mac.value;
+	output_shift = mac.output_shift;
+	bit_count = mac.bit_count;
+	return *this;
+}
+
+int24_t MAC::getUpper(bool* clamped) {
 	//Apply output shifter
 	int64_t raw_shifted = value.raw;
 	if (output_shift >= 0) {
@@ -36,8 +43,14 @@ int24_t MAC::getUpper() {
 	if (dsp->CR1.MOVM) {
 		if (upper > INT24_MAX) {
 			upper = INT24_MAX;
+			if (clamped) {
+				*clamped = true;
+			}
 		} else if (upper < INT24_MIN) {
 			upper = INT24_MIN;
+			if (clamped) {
+				*clamped = true;
+			}
 		}
 	}
 
@@ -77,7 +90,7 @@ void MAC::set(uint64_t value) {
 	this->value.raw = value;
 }
 
-void MAC::set(MAC mac) {
+void MAC::set(const MAC& mac) {
 	this->value = mac.value;
 }
 
@@ -172,7 +185,7 @@ void MAC::multiply(int24_t lhs, int24_t rhs, MACSigns signs, bool negate) {
 	
 	value.raw = mult_internal(lhs_aligned, rhs_aligned, negate);
 }
-void MAC::multiply(MAC mac, MACSigns signs, bool negate) {
+void MAC::multiply(const MAC& mac, MACSigns signs, bool negate) {
 	int64_t lhs_aligned;
 	int64_t rhs_aligned;
 
@@ -220,7 +233,7 @@ void MAC::mac(int24_t lhs, int24_t rhs, MACSigns signs, bool negate) {
 	tms_printf("MAC accumulated with raw: %llX result: %llX\n", current, value.raw);
 	//TODO: calculate flags after accumulation
 }
-void MAC::mac(MAC mac, MACSigns signs, bool negate) {
+void MAC::mac(const MAC& mac, MACSigns signs, bool negate) {
 	int64_t current = value.raw;
 	//Apply accumulation shifter
 	switch (dsp->CR1.MASM) {
@@ -261,7 +274,7 @@ void MAC::multiply(int24_t lhs, int24_t rhs, MACSigns signs) {
 
 	value.raw = mult_internal(lhs_double, rhs_double);
 }
-void MAC::multiply(MAC mac, MACSigns signs) {
+void MAC::multiply(const MAC& mac, MACSigns signs) {
 	double lhs_double = (double)value.raw / FACTOR_52;
 	double rhs_double = (double)mac.value.raw / FACTOR_52;
 	tms_printf("Multiplication %f x %f\n", lhs_double, rhs_double);
@@ -283,7 +296,7 @@ void MAC::mac(int24_t lhs, int24_t rhs, MACSigns signs) {
 
 	value.raw += mult_internal(lhs_double, rhs_double);;
 }
-void MAC::mac(MAC mac, MACSigns signs) {
+void MAC::mac(const MAC& mac, MACSigns signs) {
 	double lhs_double = (double)value.raw / FACTOR_52;
 	double rhs_double = (double)mac.value.raw / FACTOR_52;
 	tms_printf("MAC %llX + %f x %f\n", value.raw, lhs_double, rhs_double);
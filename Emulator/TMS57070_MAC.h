@@ -29,11 +29,14 @@ namespace TMS57070 {
 	class MAC {
 	public:
 		MAC(Emulator* dsp);
+		MAC(const MAC&) = delete; //A MAC belongs to one Emulator. Copy values with set() or operator=
+		MAC& operator=(const MAC& mac); //Copies value and modes, but stays attached to its own Emulator
 
-		int24_t getUpper();
+		int24_t getUpper(bool* clamped = nullptr); //clamped: set if the overflow limiter (CR1.MOVM) clamped the value
 		uint24_t getLower();
+		int64_t getRaw() { return value.raw; } //Unshifted 52-bit value
 		void set(uint64_t value);
-		void set(MAC mac); //Copy value from another MAC
+		void set(const MAC& mac); //Copy value from another MAC
 		void setUpper(int32_t value);
 		void setLower(uint32_t value);
 		void clear();
@@ -42,11 +45,11 @@ namespace TMS57070 {
 
 		void multiply(int24_t value, MACSigns signs, bool negate);
 		void multiply(int24_t lhs, int24_t rhs, MACSigns signs, bool negate);
-		void multiply(MAC mac, MACSigns signs, bool negate);
+		void multiply(const MAC& mac, MACSigns signs, bool negate);
 
 		void mac(int24_t value, MACSigns signs, bool negate);
 		void mac(int24_t lhs, int24_t rhs, MACSigns signs, bool negate);
-		void mac(MAC mac, MACSigns signs, bool negate);
+		void mac(const MAC& mac, MACSigns signs, bool negate);
 
 		void shift(int8_t amount);
 
@@ -0,0 +1,22 @@
+#include "TMS57070_clock.h"
+#include <cassert>
+
+using namespace TMS57070;
+
+void SampleClock::configure(uint32_t dsp_clock_hz, uint32_t sample_rate) {
+	assert(sample_rate != 0);
+	assert(dsp_clock_hz >= sample_rate); //Less than one cycle per sample makes no sense
+	cycles_whole = dsp_clock_hz / sample_rate;
+	cycles_remainder = dsp_clock_hz % sample_rate;
+	rate = sample_rate;
+}
+
+void SampleClock::start(uint64_t cycle) {
+	origin = cycle;
+	sample = 0;
+}
+
+uint64_t SampleClock::sample_cycle(uint64_t n) const {
+	//Split into whole and fractional parts so that n * dsp_clock cannot overflow
+	return origin + n * cycles_whole + (n * cycles_remainder) / rate;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+namespace TMS57070 {
+
+	//Default instruction clock: 512 cycles per sample at 44.1kHz, the ratio the emulator has always assumed
+	constexpr uint32_t DEFAULT_DSP_CLOCK_HZ = 22579200;
+	constexpr uint32_t DEFAULT_SAMPLE_RATE = 44100;
+
+	enum class AudioPort {
+		ARI1,
+		ARI2,
+	};
+
+	struct clock_config_t {
+		uint32_t dsp_clock_hz; //Instruction clock. Configured by the host: the CR0 clock bits are not decoded
+		uint32_t ari1_sample_rate; //Sample rate of the ARI1 audio port
+		uint32_t ari2_sample_rate; //Sample rate of the ARI2 audio port
+	};
+
+	//Converts between instruction cycles and sample periods of one audio port.
+	//Sample n arrives at origin + floor(n * dsp_clock / sample_rate), computed with integers only,
+	//so fractional ratios (e.g. 470.4 cycles per sample) never drift over long renders.
+	class SampleClock {
+	public:
+		void configure(uint32_t dsp_clock_hz, uint32_t sample_rate);
+		void start(uint64_t cycle); //Sample 0 arrives at this cycle
+
+		uint64_t sample_cycle(uint64_t sample) const; //Cycle at which the given sample arrives
+		uint64_t next_cycle() const { return sample_cycle(sample + 1); }
+		void advance() { sample++; }
+		void set_samples(uint64_t samples) { sample = samples; } //For restoring saved state
+
+		uint64_t samples() const { return sample; } //Sample periods elapsed since start()
+		uint64_t origin_cycle() const { return origin; }
+		uint32_t whole_cycles() const { return cycles_whole; } //Integer part of cycles per sample
+
+	private:
+		uint64_t origin = 0;
+		uint64_t sample = 0;
+		uint32_t cycles_whole = DEFAULT_DSP_CLOCK_HZ / DEFAULT_SAMPLE_RATE;
+		uint32_t cycles_remainder = 0; //Fractional part, in units of 1/rate
+		uint32_t rate = DEFAULT_SAMPLE_RATE;
+	};
+
+}
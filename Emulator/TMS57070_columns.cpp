@@ -0,0 +1,163 @@
+#include "TMS57070_columns.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint8_t COLUMN_MAGIC[4] = { 'T', '5', '7', 'C' };
+
+bool TMS57070::parse_trace_regs(const char* spec, std::vector<TraceReg>& registers) {
+	registers.clear();
+	while (*spec) {
+		const char* end = strchr(spec, ',');
+		size_t length = end ? (size_t)(end - spec) : strlen(spec);
+		char name[16];
+		TraceReg reg;
+		if (length == 0 || length >= sizeof(name)) {
+			return false;
+		}
+		memcpy(name, spec, length);
+		name[length] = '\0';
+		if (!trace_reg_from_name(name, &reg)) {
+			return false;
+		}
+		registers.push_back(reg);
+		spec += length + (end ? 1 : 0);
+	}
+	return !registers.empty() && registers.size() <= COLUMN_MAX;
+}
+
+ColumnRecorder::~ColumnRecorder() {
+	close();
+}
+
+bool ColumnRecorder::open(const char* path, const std::vector<TraceReg>& registers, uint32_t frames_per_chunk) {
+	assert(!registers.empty() && registers.size() <= COLUMN_MAX && frames_per_chunk > 0);
+	close();
+	file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+
+	column_count = (uint32_t)registers.size();
+	for (uint32_t column = 0; column < column_count; column++) {
+		columns[column] = (uint8_t)registers[column];
+	}
+	chunk_frames = frames_per_chunk;
+	buffer.assign((size_t)column_count * chunk_frames, 0);
+	index.clear();
+	filled = 0;
+	written_frames = 0;
+
+	//The header is rewritten with the frame count and index on close()
+	column_header_t header = {};
+	offset = sizeof(header);
+	ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	return ok;
+}
+
+void ColumnRecorder::flush() {
+	if (!filled) {
+		return;
+	}
+	static const uint8_t PADDING[COLUMN_ALIGNMENT] = {};
+	uint64_t padding = (COLUMN_ALIGNMENT - offset % COLUMN_ALIGNMENT) % COLUMN_ALIGNMENT;
+	ok = ok && fwrite(PADDING, 1, (size_t)padding, file) == padding;
+	offset += padding;
+
+	index.push_back(column_chunk_t{ offset, written_frames, filled, 0 });
+	for (uint32_t column = 0; column < column_count; column++) {
+		ok = ok && fwrite(&buffer[(size_t)column * chunk_frames], sizeof(uint32_t), filled, file) == filled;
+	}
+	offset += (uint64_t)column_count * filled * sizeof(uint32_t);
+	written_frames += filled;
+	filled = 0;
+}
+
+bool ColumnRecorder::close() {
+	if (!file) {
+		return true;
+	}
+	flush();
+
+	column_header_t header = {};
+	memcpy(header.magic, COLUMN_MAGIC, 4);
+	header.version = COLUMN_VERSION;
+	header.column_count = (uint16_t)column_count;
+	header.chunk_frames = chunk_frames;
+	header.chunk_count = (uint32_t)index.size();
+	header.frames = written_frames;
+	header.index_offset = offset;
+	memcpy(header.registers, columns, column_count);
+
+	ok = ok && fwrite(index.data(), sizeof(column_chunk_t), index.size(), file) == index.size();
+	ok = ok && seek64(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = fclose(file) == 0 && ok;
+	file = nullptr;
+	return ok;
+}
+
+ColumnReader::~ColumnReader() {
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool ColumnReader::open(const char* path) {
+	if (file) {
+		fclose(file);
+	}
+	index.clear();
+	file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, COLUMN_MAGIC, 4) == 0
+		&& header.version == COLUMN_VERSION
+		&& header.column_count <= COLUMN_MAX
+		&& header.index_offset != 0;
+	if (valid) {
+		index.resize(header.chunk_count);
+		valid = seek64(file, header.index_offset, SEEK_SET) == 0
+			&& fread(index.data(), sizeof(column_chunk_t), index.size(), file) == index.size();
+	}
+	if (!valid) {
+		fclose(file);
+		file = nullptr;
+	}
+	return valid;
+}
+
+int ColumnReader::find_column(TraceReg reg) const {
+	for (uint32_t column = 0; column < header.column_count; column++) {
+		if (header.registers[column] == (uint8_t)reg) {
+			return (int)column;
+		}
+	}
+	return -1;
+}
+
+size_t ColumnReader::read(uint32_t column, uint64_t first_frame, uint32_t* values, size_t count) {
+	if (!file || column >= header.column_count) {
+		return 0;
+	}
+	size_t done = 0;
+	size_t chunk_index = (size_t)(first_frame / header.chunk_frames); //Every chunk but the last is full
+	while (done < count && chunk_index < index.size()) {
+		const column_chunk_t& chunk = index[chunk_index++];
+		uint64_t frame = first_frame + done;
+		if (frame < chunk.first_frame || frame >= chunk.first_frame + chunk.frames) {
+			break;
+		}
+		uint64_t skip = frame - chunk.first_frame;
+		size_t length = (size_t)std::min<uint64_t>(chunk.frames - skip, count - done);
+		uint64_t position = chunk.offset + ((uint64_t)column * chunk.frames + skip) * sizeof(uint32_t);
+		if (seek64(file, position, SEEK_SET) != 0 || fread(values + done, sizeof(uint32_t), length, file) != length) {
+			break;
+		}
+		done += length;
+	}
+	return done;
+}
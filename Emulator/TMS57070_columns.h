@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	//Column file layout, in host byte order like trace files:
+	//  column_header_t
+	//  chunks, each starting at a multiple of COLUMN_ALIGNMENT: one uint32 array per column of chunk.frames values
+	//  index: column_header_t::chunk_count column_chunk_t entries at column_header_t::index_offset
+	//Values are registers as traced (see TraceReg). Chunks are page aligned, so that analysis tools can map
+	//the file and use every column of a chunk as a plain array
+	constexpr uint16_t COLUMN_VERSION = 1;
+	constexpr uint32_t COLUMN_ALIGNMENT = 4096;
+	constexpr uint32_t COLUMN_MAX = 40;
+	static_assert(TRACE_REG_COUNT <= COLUMN_MAX, "Every register must fit in a column file");
+
+	struct column_header_t {
+		uint8_t magic[4]; //"T57C"
+		uint16_t version;
+		uint16_t column_count;
+		uint32_t chunk_frames; //Frames per chunk. The last chunk may have fewer
+		uint32_t chunk_count;
+		uint64_t frames;
+		uint64_t index_offset; //0 if the recorder was not closed
+		uint8_t registers[COLUMN_MAX]; //TraceReg of each column
+	};
+	static_assert(sizeof(column_header_t) == 72, "column_header_t is a file format");
+
+	struct column_chunk_t {
+		uint64_t offset; //Column c starts at offset + c * frames * 4
+		uint64_t first_frame;
+		uint32_t frames;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(column_chunk_t) == 24, "column_chunk_t is a file format");
+
+	bool parse_trace_regs(const char* spec, std::vector<TraceReg>& registers); //Comma-separated TraceReg names, "ACC1,MAC1,CA"
+
+	//Appends registers at every sample boundary to a column file. Frames collect in a preallocated chunk buffer,
+	//which is written when full, so capturing costs a few stores per sample. Attach with Emulator::set_column_recorder()
+	class ColumnRecorder {
+	public:
+		~ColumnRecorder();
+		bool open(const char* path, const std::vector<TraceReg>& registers, uint32_t chunk_frames = 1 << 16);
+		bool close(); //Write the last chunk and the index. False if any write since open() failed
+
+		void sample(const uint32_t registers[TRACE_REG_COUNT]) {
+			for (uint32_t column = 0; column < column_count; column++) {
+				buffer[column * chunk_frames + filled] = registers[columns[column]];
+			}
+			if (++filled == chunk_frames) {
+				flush();
+			}
+		}
+		uint64_t frames() const { return written_frames + filled; }
+
+	private:
+		void flush();
+
+		FILE* file = nullptr;
+		bool ok = false;
+		uint32_t column_count = 0;
+		uint8_t columns[COLUMN_MAX];
+		uint32_t chunk_frames = 0;
+		uint32_t filled = 0; //Frames in buffer
+		std::vector<uint32_t> buffer; //Column after column, chunk_frames values each
+		std::vector<column_chunk_t> index;
+		uint64_t written_frames = 0;
+		uint64_t offset = 0; //End of the file
+	};
+
+	//Reads column files written by ColumnRecorder
+	class ColumnReader {
+	public:
+		~ColumnReader();
+		bool open(const char* path); //False if the file is not a complete column file
+
+		uint32_t columns() const { return header.column_count; }
+		TraceReg column_register(uint32_t column) const { return (TraceReg)header.registers[column]; }
+		int find_column(TraceReg reg) const; //-1 if the register was not recorded
+		uint64_t frames() const { return header.frames; }
+		size_t read(uint32_t column, uint64_t first_frame, uint32_t* values, size_t count); //Returns the number of values read
+
+	private:
+		FILE* file = nullptr;
+		column_header_t header;
+		std::vector<column_chunk_t> index;
+	};
+
+}
@@ -5,6 +5,7 @@ using namespace TMS57070;
 
 //Decodes a load instruction and sets the ACC accordingly
 //Returns pointer to the destination ACC
+template <class Core>
 int24_t* Emulator::loadACCarith(ArithOperation operation) {
 	int32_t result;
 	//Where is the data destination?
@@ -16,10 +17,10 @@ int24_t* Emulator::loadACCarith(ArithOperation operation) {
 	uint8_t src_code = opcode1 & 3;
 	switch (src_code) {
 	case 0:
-		result = DMEM[dmemAddressing()].value;
+		result = DMEM[dmemAddressing<Core>()].value;
 		break;
 	case 1:
-		result = CMEM[cmemAddressing()].value;
+		result = CMEM[cmemAddressing<Core>()].value;
 		break;
 	case 2:
 		if (opcode1_flag8) {
@@ -30,9 +31,9 @@ int24_t* Emulator::loadACCarith(ArithOperation operation) {
 		break;
 	case 3:
 		if (opcode1_flag8) {
-			result = MACC2_delayed2.getUpper().value;
+			result = macUpper(MACC2_delayed2).value;
 		} else {
-			result = MACC1_delayed2.getUpper().value;
+			result = macUpper(MACC1_delayed2).value;
 		}
 		break;
 	default:
@@ -75,6 +76,7 @@ int24_t* Emulator::loadACCarith(ArithOperation operation) {
 }
 
 //Returns pointer to the destination ACC
+template <class Core>
 int24_t* Emulator::arith(ArithOperation operation) {
 	//Where is the data destination?
 	int24_t* dst = &ACC1;
@@ -87,12 +89,12 @@ int24_t* Emulator::arith(ArithOperation operation) {
 	int24_t rhs{};
 	if ((opcode1 == 0x3C) || (opcode1 == 0x3D) || (opcode1 == 0x3E)) {
 		//These instructions use CMEM and DMEM always
-		lhs.value = DMEM[dmemAddressing()].value;
-		rhs.value = CMEM[cmemAddressing()].value;
+		lhs.value = DMEM[dmemAddressing<Core>()].value;
+		rhs.value = CMEM[cmemAddressing<Core>()].value;
 	} else { //Normal ALU instructions
 		switch (src_code) {
 		case 0: //DMEM op ACCx
-			lhs.value = DMEM[dmemAddressing()].value;
+			lhs.value = DMEM[dmemAddressing<Core>()].value;
 			if (opcode1_flag8) {
 				rhs.value = ACC2.value;
 			} else {
@@ -100,15 +102,15 @@ int24_t* Emulator::arith(ArithOperation operation) {
 			}
 			break;
 		case 1: //DMEM op MACCx
-			lhs.value = DMEM[dmemAddressing()].value;
+			lhs.value = DMEM[dmemAddressing<Core>()].value;
 			if (opcode1_flag8) {
-				rhs.value = MACC2_delayed2.getUpper().value;
+				rhs.value = macUpper(MACC2_delayed2).value;
 			} else {
-				rhs.value = MACC1_delayed2.getUpper().value;
+				rhs.value = macUpper(MACC1_delayed2).value;
 			}
 			break;
 		case 2: //CMEM op ACCx
-			lhs.value = CMEM[cmemAddressing()].value;
+			lhs.value = CMEM[cmemAddressing<Core>()].value;
 			if (opcode1_flag8) {
 				rhs.value = ACC2.value;
 			} else {
@@ -116,11 +118,11 @@ int24_t* Emulator::arith(ArithOperation operation) {
 			}
 			break;
 		case 3: //CMEM op MACCx
-			lhs.value = CMEM[cmemAddressing()].value;
+			lhs.value = CMEM[cmemAddressing<Core>()].value;
 			if (opcode1_flag8) {
-				rhs.value = MACC2_delayed2.getUpper().value;
+				rhs.value = macUpper(MACC2_delayed2).value;
 			} else {
-				rhs.value = MACC1_delayed2.getUpper().value;
+				rhs.value = macUpper(MACC1_delayed2).value;
 			}
 			break;
 		default:
@@ -150,6 +152,9 @@ int24_t* Emulator::arith(ArithOperation operation) {
 	case ArithOperation::Cmp:
 		//Quit early to avoid writing to ACC
 		result = lhs.value - rhs.value;
+		if (overflow && !CR1.AOV && ((result < INT24_MIN) || (result > INT24_MAX))) {
+			overflow->aov_latched();
+		}
 		CR1.AOV = (result < INT24_MIN) || (result > INT24_MAX);
 		CR1.ACCZ = result == 0;
 		CR1.ACCN = result < 0;
@@ -171,6 +176,16 @@ int24_t* Emulator::arith(ArithOperation operation) {
 //applies saturation logic, truncates, and sets overflow flag
 //returns the correct value to load
 int32_t Emulator::processACCValue(int32_t acc) {
+	if (overflow && ((acc < INT24_MIN) || (acc > INT24_MAX))) {
+		if (CR1.AOVM) {
+			overflow->acc_saturated();
+		} else {
+			overflow->acc_wrapped();
+		}
+		if (!CR1.AOV) {
+			overflow->aov_latched();
+		}
+	}
 	if (CR1.AOVM) { //saturation logic on
 		if (acc < INT24_MIN) {
 			//Saturate at minimum
@@ -198,6 +213,7 @@ int32_t Emulator::processACCValue(int32_t acc) {
 	return acc_i24.value;
 }
 
+template <class Core>
 void Emulator::execPrimary() {
 	opcode1 = insn >> 24;
 	opcode1_flag4 = insn & 0x00400000;
@@ -214,42 +230,42 @@ void Emulator::execPrimary() {
 	case 0x5:
 	case 0x6:
 	case 0x7:
-		loadACCarith(ArithOperation::LoadUnsigned);
+		loadACCarith<Core>(ArithOperation::LoadUnsigned);
 		break;
 
 	case 0x8: //Load accumulator with 2's complement aka negate
 	case 0x9:
 	case 0xA:
 	case 0xB:
-		loadACCarith(ArithOperation::TwosComplement);
+		loadACCarith<Core>(ArithOperation::TwosComplement);
 		break;
 
 	case 0x0C: //Load accumulator with 1's complement
 	case 0x0D:
 	case 0x0E:
 	case 0x0F:
-		loadACCarith(ArithOperation::OnesComplement);
+		loadACCarith<Core>(ArithOperation::OnesComplement);
 		break;
 
 	case 0x10: //Load accumulator
 	case 0x11:
 	case 0x12:
 	case 0x13:
-		loadACCarith(ArithOperation::Load);
+		loadACCarith<Core>(ArithOperation::Load);
 		break;
 
 	case 0x14: //Increment and load accumulator
 	case 0x15:
 	case 0x16:
 	case 0x17:
-		loadACCarith(ArithOperation::Increment);
+		loadACCarith<Core>(ArithOperation::Increment);
 		break;
 
 	case 0x18: //Decrement and load accumulator
 	case 0x19:
 	case 0x1A:
 	case 0x1B:
-		loadACCarith(ArithOperation::Decrement);
+		loadACCarith<Core>(ArithOperation::Decrement);
 		break;
 
 	case 0x1C:
@@ -272,8 +288,8 @@ void Emulator::execPrimary() {
 
 	case 0x1D: //ZACC Zero accumulator (and something else)
 		if (opcode1_flag8) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
 			//ZACC zero accumulator
@@ -288,22 +304,22 @@ void Emulator::execPrimary() {
 
 	case 0x1E: //Load dual data from MACC into ACC
 		if (opcode1_flag4) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
 			MAC* MACx = &MACC1;
 			if (opcode1_flag8) MACx = &MACC2;
 
-			ACC2.value = MACx->getUpper().value;
+			ACC2.value = macUpper(*MACx).value;
 			ACC1.value = MACx->getLower().value;
 		}
 		break;
 
 	case 0x1F: //ZACC Zero accumulators (and something else)
 		if (opcode1_flag8 || opcode1_flag4) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
 			//ZACC zero accumulators
@@ -318,7 +334,7 @@ void Emulator::execPrimary() {
 	case 0x22:
 	case 0x23:
 	{
-		int24_t* dst = arith(ArithOperation::Add);
+		int24_t* dst = arith<Core>(ArithOperation::Add);
 		tms_printf("Set ACC%d to %X\n", opcode1_flag4 + 1, dst->value);
 	} break;
 
@@ -327,7 +343,7 @@ void Emulator::execPrimary() {
 	case 0x26:
 	case 0x27:
 	{
-		int24_t* dst = arith(ArithOperation::Sub);
+		int24_t* dst = arith<Core>(ArithOperation::Sub);
 		tms_printf("Set ACC%d to %X\n", opcode1_flag4 + 1, dst->value);
 	} break;
 
@@ -336,7 +352,7 @@ void Emulator::execPrimary() {
 	case 0x2A:
 	case 0x2B:
 	{
-		int24_t* dst = arith(ArithOperation::And);
+		int24_t* dst = arith<Core>(ArithOperation::And);
 		tms_printf("Set ACC%d to %X\n", opcode1_flag4 + 1, dst->value);
 	} break;
 
@@ -345,7 +361,7 @@ void Emulator::execPrimary() {
 	case 0x2E:
 	case 0x2F:
 	{
-		int24_t* dst = arith(ArithOperation::Or);
+		int24_t* dst = arith<Core>(ArithOperation::Or);
 		tms_printf("Set ACC%d to %X\n", opcode1_flag4 + 1, dst->value);
 	} break;
 
@@ -354,7 +370,7 @@ void Emulator::execPrimary() {
 	case 0x32:
 	case 0x33:
 	{
-		int24_t* dst = arith(ArithOperation::Xor);
+		int24_t* dst = arith<Core>(ArithOperation::Xor);
 		tms_printf("Set ACC%d to %X\n", opcode1_flag4 + 1, dst->value);
 	} break;
 
@@ -363,7 +379,7 @@ void Emulator::execPrimary() {
 	case 0x36:
 	case 0x37:
 	{
-		int24_t* dst = arith(ArithOperation::Cmp);
+		int24_t* dst = arith<Core>(ArithOperation::Cmp);
 	} break;
 
 	case 0x38: //Weird
@@ -374,7 +390,8 @@ void Emulator::execPrimary() {
 		int24_t* ACCx = &ACC1;
 		if (opcode1_flag4) ACCx = &ACC2;
 
-		if ((MACx->getUpper().value >= 0x400000) || (MACx->getUpper().value < -0x400000)) {
+		int32_t upper = macUpper(*MACx).value;
+		if ((upper >= 0x400000) || (upper < -0x400000)) {
 			//do nothing
 		} else {
 			//Left-shift MACx and decrement ACCx
@@ -386,25 +403,22 @@ void Emulator::execPrimary() {
 
 	case 0x39:
 		if (opcode1_flag4) { //WRE
-			//FIXME: write is not immediate and can clash with other XMEM operations
-			XMEM[xmemAddressing(CMEM[cmemAddressing()].value)].value = DMEM[dmemAddressing()].value;
-			tms_printf("External write. addr=%06X data=%06X PC=%X\n", xmemAddressing(CMEM[cmemAddressing()].value), DMEM[dmemAddressing()].value, PC.value);
+			//FIXME: a delayed write can still clash with other XMEM operations
+			uint32_t write_addr = xmemAddressing<Core>(CMEM[cmemAddressing<Core>()].value);
+			int32_t write_data = DMEM[dmemAddressing<Core>()].value;
+			if (Core::XMEM_WRITE_DELAYED) {
+				schedule(event_t{ cycle + xmem_access_cycles(), 0, EventType::XMEMWrite, 0, write_addr, write_data });
+			} else {
+				xmemWrite<Core>(write_addr, write_data);
+			}
+			tms_printf("External write. addr=%06X data=%06X PC=%X\n", write_addr, write_data, PC.value);
 		} else { //RDE
-			XMEM_read_addr = xmemAddressing(CMEM[cmemAddressing()].value);
-			tms_printf("External read. addr=%06X PC=%X\n", XMEM_read_addr, PC.value);
-			switch (CR3.XBUS) {
-			case 0: //4-bit
-				XMEM_read_cycles = CR3.XWORD ? 21 : 15;
-				break;
-			case 1: //8-bit
-				XMEM_read_cycles = CR3.XWORD ? 12 : 9;
-				break;
-			case 2: //12-bit
-				XMEM_read_cycles = CR3.XWORD ? 9 : 0;
-				break;
-			case 3: //16-bit
-				XMEM_read_cycles = CR3.XWORD ? 0 : 6;
-				break;
+			uint32_t read_addr = xmemAddressing<Core>(CMEM[cmemAddressing<Core>()].value);
+			tms_printf("External read. addr=%06X PC=%X\n", read_addr, PC.value);
+			cancel(EventType::XMEMRead); //A new read replaces any read in progress
+			uint32_t read_cycles = xmem_access_cycles();
+			if (read_cycles != 0) { //Zero: timing unknown for this bus configuration, the read never completes
+				schedule(event_t{ cycle + read_cycles, 0, EventType::XMEMRead, 0, read_addr, 0 });
 			}
 		}
 		break;
@@ -416,25 +430,25 @@ void Emulator::execPrimary() {
 
 	case 0x3C: //ADD CMEM + DMEM
 		if (opcode1_flag8) {
-			arith(ArithOperation::Sub);
+			arith<Core>(ArithOperation::Sub);
 		} else {
-			arith(ArithOperation::Add);
+			arith<Core>(ArithOperation::Add);
 		}
 		break;
 	case 0x3D: //AND bitwise CMEM AND DMEM
 		if (opcode1_flag8) {
-			arith(ArithOperation::Or);
+			arith<Core>(ArithOperation::Or);
 		} else {
-			arith(ArithOperation::And);
+			arith<Core>(ArithOperation::And);
 		}
 		break;
 	case 0x3E: //XOR bitwise CMEM AND DMEM
 		if (opcode1_flag8) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
-			arith(ArithOperation::Xor);
+			arith<Core>(ArithOperation::Xor);
 		}
 		break;
 
@@ -458,7 +472,7 @@ void Emulator::execPrimary() {
 		int24_t* ACCx = &ACC1;
 		if ((opcode1 & 1) == 1) ACCx = &ACC2;
 
-		int24_t* cmem_word = &CMEM[cmemAddressing()];
+		int24_t* cmem_word = &CMEM[cmemAddressing<Core>()];
 
 		MACSigns signs;
 		switch (opcode1) {
@@ -481,8 +495,8 @@ void Emulator::execPrimary() {
 
 		bool negate = opcode1_flag8;
 		
-		int24_t* cmem_word = &CMEM[cmemAddressing()];
-		int24_t* dmem_word = &DMEM[dmemAddressing()];
+		int24_t* cmem_word = &CMEM[cmemAddressing<Core>()];
+		int24_t* dmem_word = &DMEM[dmemAddressing<Core>()];
 
 		MACSigns signs;
 		switch (opcode1) {
@@ -505,7 +519,7 @@ void Emulator::execPrimary() {
 
 		bool negate = opcode1_flag8;
 
-		int24_t* dmem_word = &DMEM[dmemAddressing()];
+		int24_t* dmem_word = &DMEM[dmemAddressing<Core>()];
 
 		MACSigns signs;
 		if ((opcode1 & 8) == 0) {
@@ -514,8 +528,8 @@ void Emulator::execPrimary() {
 			signs = MACSigns::UU;
 		}*/
 
-		if (UNKNOWN_STRICT) {
-			assert(false); //Uses MACLO, unimplemented
+		if (Core::STRICT) {
+			fault(); //Uses MACLO, unimplemented
 		}
 
 		//MACx->multiply(MACLO.value, *dmem_word, signs, negate);
@@ -536,9 +550,9 @@ void Emulator::execPrimary() {
 
 		int24_t* word;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 		}
 		
 		MACx->mac(*ACCx, *word, MACSigns::SS, negate);
@@ -560,10 +574,10 @@ void Emulator::execPrimary() {
 		int24_t* word;
 		MACSigns signs;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 			signs = MACSigns::SU;
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 			signs = MACSigns::US;
 		}
 		MACx->mac(*ACCx, *word, signs, negate);
@@ -585,10 +599,10 @@ void Emulator::execPrimary() {
 		int24_t* word;
 		MACSigns signs;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 			signs = MACSigns::US;
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 			signs = MACSigns::SU;
 		}
 		MACx->mac(*ACCx, *word, signs, negate);
@@ -609,9 +623,9 @@ void Emulator::execPrimary() {
 
 		int24_t* word;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 		}
 		MACx->mac(*ACCx, *word, MACSigns::UU, negate);
 	} break;
@@ -631,9 +645,9 @@ void Emulator::execPrimary() {
 
 		int24_t* word;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 		}
 
 		//Shift MAC right by 24
@@ -660,10 +674,10 @@ void Emulator::execPrimary() {
 		int24_t* word;
 		MACSigns signs;
 		if ((opcode1 & 2) == 0) {
-			word = &CMEM[cmemAddressing()];
+			word = &CMEM[cmemAddressing<Core>()];
 			signs = MACSigns::SU;
 		} else {
-			word = &DMEM[dmemAddressing()];
+			word = &DMEM[dmemAddressing<Core>()];
 			signs = MACSigns::US;
 		}
 
@@ -691,8 +705,8 @@ void Emulator::execPrimary() {
 
 		bool negate = opcode1_flag8;
 		
-		int24_t* cmem_word = &CMEM[cmemAddressing()];
-		int24_t* dmem_word = &DMEM[dmemAddressing()];
+		int24_t* cmem_word = &CMEM[cmemAddressing<Core>()];
+		int24_t* dmem_word = &DMEM[dmemAddressing<Core>()];
 
 		MACSigns signs;
 		switch (opcode1) {
@@ -713,8 +727,8 @@ void Emulator::execPrimary() {
 
 		bool negate = opcode1_flag8;
 
-		int24_t* cmem_word = &CMEM[cmemAddressing()];
-		int24_t* dmem_word = &DMEM[dmemAddressing()];
+		int24_t* cmem_word = &CMEM[cmemAddressing<Core>()];
+		int24_t* dmem_word = &DMEM[dmemAddressing<Core>()];
 
 		MACSigns signs = MACSigns::SS;
 		if (opcode1 == 0x71) {
@@ -743,8 +757,8 @@ void Emulator::execPrimary() {
 
 	case 0x73: //Zero MACC (and something else)
 		if (opcode1_flag8) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
 			//Zero MACC
@@ -757,8 +771,8 @@ void Emulator::execPrimary() {
 
 	case 0x74: //Zero both MACCs (and something else)
 		if (opcode1_flag8 || opcode1_flag4) {
-			if (UNKNOWN_STRICT) {
-				assert(false); //idk
+			if (Core::STRICT) {
+				fault(); //idk
 			}
 		} else {
 			//Zero MACCs
@@ -790,13 +804,13 @@ void Emulator::execPrimary() {
 			if (opcode1_flag8) {
 				load_word.value = ACC1.value;
 			} else {
-				load_word.value = DMEM[dmemAddressing()].value;
+				load_word.value = DMEM[dmemAddressing<Core>()].value;
 			}
 		} else { //Instructions 79, 7B, 7D: CMEM and ACC2
 			if (opcode1_flag8) {
 				load_word.value = ACC2.value;
 			} else {
-				load_word.value = CMEM[cmemAddressing()].value;
+				load_word.value = CMEM[cmemAddressing<Core>()].value;
 			}
 		}
 		if (opcode1 < 0x7C) { //load MAC high
@@ -841,8 +855,8 @@ void Emulator::execPrimary() {
 			}
 			break;
 		default:
-			if (UNKNOWN_STRICT) {
-				assert(false); //unknown
+			if (Core::STRICT) {
+				fault(); //unknown
 			}
 			break;
 		}
@@ -908,6 +922,7 @@ void Emulator::execPrimary() {
 		uint8_t flagsToClear = temp.bytes[0] & CR2.bytes[0]; //Only clear flags that are common to both the input value and current value
 		temp.bytes[0] = CR2.bytes[0] ^ flagsToClear; //Erase common bits
 		CR2.value = temp.value;
+		irq_poll = true;
 	} break;
 	case 0xCF: //Load CR3 imm
 		CR3.value = insn;
@@ -917,16 +932,19 @@ void Emulator::execPrimary() {
 		RPTC = insn >> 16;
 		rep_start_PC.value = PC.value;
 		rep_end_PC.value = PC.value;
+		Core::Hooks::repeat_start(*this, rep_start_PC.value, rep_end_PC.value, RPTC);
 		break;
 	case 0xE2: //RPTK by ACC1
 		RPTC = ACC1.value;
 		rep_start_PC.value = PC.value;
 		rep_end_PC.value = PC.value;
+		Core::Hooks::repeat_start(*this, rep_start_PC.value, rep_end_PC.value, RPTC);
 		break;
 	case 0xE3: //RPTK by ACC2
 		RPTC = ACC2.value;
 		rep_start_PC.value = PC.value;
 		rep_end_PC.value = PC.value;
+		Core::Hooks::repeat_start(*this, rep_start_PC.value, rep_end_PC.value, RPTC);
 		break;
 	case 0xE4: //RTPB repeat block
 		RPTC = insn >> 16;
@@ -935,18 +953,27 @@ void Emulator::execPrimary() {
 		if (rep_end_PC.value == PC.value) {
 			RPTC = 0; //RPTB cannot do a single-instruction loop
 		}
+		Core::Hooks::repeat_start(*this, rep_start_PC.value, rep_end_PC.value, RPTC);
 		break;
 
 	case 0xEC: //RET
-		assert(SP != 0); //Stack underflow!
+		if (SP == 0) { //Stack underflow!
+			fault();
+			break;
+		}
 		SP--;
 		PC.value = stack[SP].value;
 		break;
 	case 0xEE: //RETI
-		assert(SP != 0); //Stack underflow!
+		if (SP == 0) { //Stack underflow!
+			fault();
+			break;
+		}
 		SP--;
 		PC.value = stack[SP].value;
 		CR2.FREE = 1;
+		Core::Hooks::interrupt_exit(*this, PC.value);
+		irq_poll = true;
 		RPTC = 0;
 		break;
 
@@ -966,19 +993,20 @@ void Emulator::execPrimary() {
 	case 0xFD:
 	case 0xFE:
 	case 0xFF:
-		execJmp();
+		execJmp<Core>();
 		break;
 
 	default:
 		tms_printf("Unhandled 1st instruction: %08X\n", insn);
-		if (UNKNOWN_STRICT) {
-			printf("Unhandled 1st instruction: %08X\n", insn); //always print if we hit the assert
-			assert(false);
+		if (Core::STRICT) {
+			printf("Unhandled 1st instruction: %08X\n", insn); //always print if we hit the fault
+			fault();
 		}
 		break;
 	}
 }
 
+template <class Core>
 void Emulator::execSecondary() {
 	opcode2 = (insn >> 16) & 0x3F;
 	opcode2_flag4 = insn & 0x00004000;
@@ -993,16 +1021,16 @@ void Emulator::execSecondary() {
 		if (opcode2_flag4) {
 			//ACC2
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = ACC2.value;
+				cmemWrite<Core>(cmemAddressing<Core>(), ACC2.value);
 			} else {
-				DMEM[dmemAddressing()].value = ACC2.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), ACC2.value);
 			}
 		} else {
 			//ACC1
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = ACC1.value;
+				cmemWrite<Core>(cmemAddressing<Core>(), ACC1.value);
 			} else {
-				DMEM[dmemAddressing()].value = ACC1.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), ACC1.value);
 			}
 		}
 		break;
@@ -1010,16 +1038,16 @@ void Emulator::execSecondary() {
 		if (opcode2_flag4) {
 			//MACC2
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = MACC2_delayed2.getUpper().value;
+				cmemWrite<Core>(cmemAddressing<Core>(), macUpper(MACC2_delayed2).value);
 			} else {
-				DMEM[dmemAddressing()].value = MACC2_delayed2.getUpper().value;
+				dmemWrite<Core>(dmemAddressing<Core>(), macUpper(MACC2_delayed2).value);
 			}
 		} else {
 			//MACC1
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = MACC1_delayed2.getUpper().value;
+				cmemWrite<Core>(cmemAddressing<Core>(), macUpper(MACC1_delayed2).value);
 			} else {
-				DMEM[dmemAddressing()].value = MACC1_delayed2.getUpper().value;
+				dmemWrite<Core>(dmemAddressing<Core>(), macUpper(MACC1_delayed2).value);
 			}
 		}
 		break;
@@ -1027,16 +1055,16 @@ void Emulator::execSecondary() {
 		if (opcode2_flag4) {
 			//MACC2
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = MACC2_delayed2.getLower().value;
+				cmemWrite<Core>(cmemAddressing<Core>(), MACC2_delayed2.getLower().value);
 			} else {
-				DMEM[dmemAddressing()].value = MACC2_delayed2.getLower().value;
+				dmemWrite<Core>(dmemAddressing<Core>(), MACC2_delayed2.getLower().value);
 			}
 		} else {
 			//MACC1
 			if (opcode2_flag8) {
-				CMEM[cmemAddressing()].value = MACC1_delayed2.getLower().value;
+				cmemWrite<Core>(cmemAddressing<Core>(), MACC1_delayed2.getLower().value);
 			} else {
-				DMEM[dmemAddressing()].value = MACC1_delayed2.getLower().value;
+				dmemWrite<Core>(dmemAddressing<Core>(), MACC1_delayed2.getLower().value);
 			}
 		}
 		break;
@@ -1073,7 +1101,7 @@ void Emulator::execSecondary() {
 	case 0x06: //Load dual from CMEM
 	{
 		//Load: (arg = 0-3) DA, DIR, CA, DIR
-		uint32_t value = CMEM[cmemAddressing()].value;
+		uint32_t value = CMEM[cmemAddressing<Core>()].value;
 		switch (opcode2_args) {
 		case 0: //Load DA
 			DA.one.value = (value & 0xFFF);
@@ -1096,46 +1124,46 @@ void Emulator::execSecondary() {
 	case 0x07: //Save dual to CMEM
 		switch (opcode2_args) {
 		case 0: //Save DA
-			CMEM[cmemAddressing()].value = DA.two.value << 12 | DA.one.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), DA.two.value << 12 | DA.one.value);
 			break;
 		case 1: //Save DIR
-			CMEM[cmemAddressing()].value = DIR.two.value << 12 | DIR.one.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), DIR.two.value << 12 | DIR.one.value);
 			break;
 		case 2: //Save CA
-			CMEM[cmemAddressing()].value = CA.two.value << 12 | CA.one.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CA.two.value << 12 | CA.one.value);
 			break;
 		case 3: //Save CIR
-			CMEM[cmemAddressing()].value = CIR.two.value << 12 | CIR.one.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CIR.two.value << 12 | CIR.one.value);
 			break;
 		}
 		break;
 	case 0x08: //Dereference CMEM ptr to DMEM addressing register
 		if (opcode2_flag4) { //If 4 set, store in incrementing register
 			if (opcode2_flag8) {
-				DIR.two.value = CMEM[cmemAddressing()].value;
+				DIR.two.value = CMEM[cmemAddressing<Core>()].value;
 			} else {
-				DIR.one.value = CMEM[cmemAddressing()].value;
+				DIR.one.value = CMEM[cmemAddressing<Core>()].value;
 			}
 		} else {
 			if (opcode2_flag8) {
-				DA.two.value = CMEM[cmemAddressing()].value;
+				DA.two.value = CMEM[cmemAddressing<Core>()].value;
 			} else {
-				DA.one.value = CMEM[cmemAddressing()].value;
+				DA.one.value = CMEM[cmemAddressing<Core>()].value;
 			}
 		}
 		break;
 	case 0x09: //Dereference CMEM ptr to CMEM addressing register //FIXME: combine with 0x08?
 		if (opcode2_flag4) { //If 4 set, store in incrementing register
 			if (opcode2_flag8) {
-				CIR.two.value = CMEM[cmemAddressing()].value;
+				CIR.two.value = CMEM[cmemAddressing<Core>()].value;
 			} else {
-				CIR.one.value = CMEM[cmemAddressing()].value;
+				CIR.one.value = CMEM[cmemAddressing<Core>()].value;
 			}
 		} else {
 			if (opcode2_flag8) {
-				CA.two.value = CMEM[cmemAddressing()].value;
+				CA.two.value = CMEM[cmemAddressing<Core>()].value;
 			} else {
-				CA.one.value = CMEM[cmemAddressing()].value;
+				CA.one.value = CMEM[cmemAddressing<Core>()].value;
 			}
 		}
 		break;
@@ -1160,84 +1188,84 @@ void Emulator::execSecondary() {
 			}
 		}
 		assert(reg != nullptr);
-		CMEM[cmemAddressing()].value = reg->value;
+		cmemWrite<Core>(cmemAddressing<Core>(), reg->value);
 	} break;
 
 	case 0x0C: //Audio input
 	case 0x0D:
 		if (opcode2_flag8) { //right channel
 			if (opcode2 == 0x0C) {
-				DMEM[dmemAddressing()].value = AR1R.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), AR1R.value);
 			} else {
-				DMEM[dmemAddressing()].value = AR2R.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), AR2R.value);
 			}
 		} else { //left channel
 			if (opcode2 == 0x0C) {
-				DMEM[dmemAddressing()].value = AR1L.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), AR1L.value);
 			} else {
-				DMEM[dmemAddressing()].value = AR2L.value;
+				dmemWrite<Core>(dmemAddressing<Core>(), AR2L.value);
 			}
 		}
 		break;
 	case 0x0E: //Non-existent channels
 	case 0x0F:
-		DMEM[dmemAddressing()].value = 0;
+		dmemWrite<Core>(dmemAddressing<Core>(), 0);
 		break;
 
 	case 0x18:
 		if (opcode2_flag8) { //right channel
 			if (opcode2_flag4) {
-				AX1R.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_1R, AX1R.value);
+				AX1R.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_1R, AX1R.value);
 			} else {
-				AX1R.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_1R, AX1R.value);
+				AX1R.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_1R, AX1R.value);
 			}
 		} else { //left channel
 			if (opcode2_flag4) {
-				AX1L.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_1L, AX1L.value);
+				AX1L.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_1L, AX1L.value);
 			} else {
-				AX1L.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_1L, AX1L.value);
+				AX1L.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_1L, AX1L.value);
 			}
 		}
 		break;
 	case 0x19:
 		if (opcode2_flag8) { //right channel
 			if (opcode2_flag4) {
-				AX2R.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_2R, AX2R.value);
+				AX2R.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_2R, AX2R.value);
 			} else {
-				AX2R.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_2R, AX2R.value);
+				AX2R.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_2R, AX2R.value);
 			}
 		} else { //left channel
 			if (opcode2_flag4) {
-				AX2L.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_2L, AX2L.value);
+				AX2L.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_2L, AX2L.value);
 			} else {
-				AX2L.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_2L, AX2L.value);
+				AX2L.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_2L, AX2L.value);
 			}
 		}
 		break;
 	case 0x1A:
 		if (opcode2_flag8) { //right channel
 			if (opcode2_flag4) {
-				AX3R.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_3R, AX3R.value);
+				AX3R.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_3R, AX3R.value);
 			} else {
-				AX3R.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_3R, AX3R.value);
+				AX3R.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_3R, AX3R.value);
 			}
 		} else { //left channel
 			if (opcode2_flag4) {
-				AX3L.value = MACC2_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_3L, AX3L.value);
+				AX3L.value = macUpper(MACC2_delayed2).value;
+				sample_out(Channel::out_3L, AX3L.value);
 			} else {
-				AX3L.value = MACC1_delayed2.getUpper().value;
-				sample_out_cb(Channel::out_3L, AX3L.value);
+				AX3L.value = macUpper(MACC1_delayed2).value;
+				sample_out(Channel::out_3L, AX3L.value);
 			}
 		}
 		break;
@@ -1245,19 +1273,19 @@ void Emulator::execSecondary() {
 	case 0x20:
 		switch (opcode2_args) {
 		case 0: //Write DMEM to T
-			T.value = DMEM[dmemAddressing()].value;
+			T.value = DMEM[dmemAddressing<Core>()].value;
 			break;
 		case 1: //Write T to GMEM
-			if (UNKNOWN_STRICT) {
-				assert(false); //Not implemented
+			if (Core::STRICT) {
+				fault(); //Not implemented
 			}
 			break;
 		case 2: //Save XRD to DMEM
-			DMEM[dmemAddressing()].value = XRD.value;
+			dmemWrite<Core>(dmemAddressing<Core>(), XRD.value);
 			break;
 		case 3:
-			if (UNKNOWN_STRICT) {
-				assert(false); //Broken/idk
+			if (Core::STRICT) {
+				fault(); //Broken/idk
 			}
 			break;
 		}
@@ -1284,20 +1312,21 @@ void Emulator::execSecondary() {
 	case 0x22: //Save CMEM to CR
 		switch (opcode2_args) {
 		case 0:
-			CR0.value = CMEM[cmemAddressing()].value;
+			CR0.value = CMEM[cmemAddressing<Core>()].value;
 			tms_printf("CR0 set to %06X\n", CR0.value);
 			break;
 		case 1:
-			CR1.value = CMEM[cmemAddressing()].value;
+			CR1.value = CMEM[cmemAddressing<Core>()].value;
 			update_mac_modes();
 			tms_printf("CR1 set to %06X\n", CR1.value);
 			break;
 		case 2:
-			CR2.value = CMEM[cmemAddressing()].value;
+			CR2.value = CMEM[cmemAddressing<Core>()].value;
+			irq_poll = true;
 			tms_printf("CR2 set to %06X\n", CR2.value);
 			break;
 		case 3:
-			CR3.value = CMEM[cmemAddressing()].value;
+			CR3.value = CMEM[cmemAddressing<Core>()].value;
 			tms_printf("CR3 set to %06X\n", CR3.value);
 			break;
 		}
@@ -1305,19 +1334,19 @@ void Emulator::execSecondary() {
 	case 0x23: //Save CR to CMEM
 		switch (opcode2_args) {
 		case 0:
-			CMEM[cmemAddressing()].value = CR0.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CR0.value);
 			tms_printf("CR0 is %06X\n", CR0.value);
 			break;
 		case 1:
-			CMEM[cmemAddressing()].value = CR1.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CR1.value);
 			tms_printf("CR1 is %06X\n", CR1.value);
 			break;
 		case 2:
-			CMEM[cmemAddressing()].value = CR2.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CR2.value);
 			tms_printf("CR2 is %06X\n", CR2.value);
 			break;
 		case 3:
-			CMEM[cmemAddressing()].value = CR3.value;
+			cmemWrite<Core>(cmemAddressing<Core>(), CR3.value);
 			tms_printf("CR3 is %06X\n", CR3.value);
 			break;
 		}
@@ -1325,26 +1354,30 @@ void Emulator::execSecondary() {
 
 	case 0x26: //Load HIR with a value from C/DMEM
 		if (opcode2_flag8) {
-			HIR.value = CMEM[cmemAddressing()].value;
+			HIR.value = CMEM[cmemAddressing<Core>()].value;
 		} else {
-			HIR.value = DMEM[dmemAddressing()].value;
+			HIR.value = DMEM[dmemAddressing<Core>()].value;
 		}
 		break;
 
 	case 0x27: //Handle circular memory
 		if (!CR1.LCMEM) {
-			uint32_t current_end = CMEM[cmemAddressing(CCIRC.value)].value;
+			uint32_t current_end = CMEM[cmemAddressing<Core>(CCIRC.value)].value;
 			COFF.value--;
-			CMEM[cmemAddressing(0x0)].value = current_end; //Set new start to old end
+			uint32_t start = cmemAddressing<Core>(0x0);
+			cmemWrite<Core>(start, current_end); //Set new start to old end
+			Core::Hooks::circular(*this, TraceTarget::CMEM, start, CCIRC.value);
 		}
 		if (!CR1.LDMEM) {
-			uint32_t current_end = DMEM[dmemAddressing(DCIRC.value)].value;
+			uint32_t current_end = DMEM[dmemAddressing<Core>(DCIRC.value)].value;
 			DOFF.value--;
-			DMEM[dmemAddressing(0x0)].value = current_end; //Set new start to old end
-
+			uint32_t start = dmemAddressing<Core>(0x0);
+			dmemWrite<Core>(start, current_end); //Set new start to old end
+			Core::Hooks::circular(*this, TraceTarget::DMEM, start, DCIRC.value);
 		}
 		if (!CR3.LXMEM) {
 			XOFF--;
+			Core::Hooks::circular(*this, TraceTarget::XMEM, XOFF & xmem_mask(), 0);
 		}
 		CA.two.value = 0;
 		DA.two.value = 0;
@@ -1376,6 +1409,7 @@ void Emulator::execSecondary() {
 			}
 		} else {
 			CR2.FREE = opcode2_flag4;
+			irq_poll = true;
 		}
 		break;
 	case 0x2D:
@@ -1397,10 +1431,8 @@ void Emulator::execSecondary() {
 	case 0x31:
 	case 0x32:
 	case 0x33:
-		DMEM[dmemAddressing()].value = XRD.value;
-		if (ext_bus_in_cb) {
-			XRD.value = ext_bus_in_cb(CMEM[cmemAddressing()].value);
-		}
+		dmemWrite<Core>(dmemAddressing<Core>(), XRD.value);
+		ext_bus_read(CMEM[cmemAddressing<Core>()].value);
 		break;
 
 	case 0x38:
@@ -1408,20 +1440,21 @@ void Emulator::execSecondary() {
 	case 0x3A:
 	case 0x3B:
 		if (ext_bus_out_cb) {
-			ext_bus_out_cb(DMEM[dmemAddressing()].value, CMEM[cmemAddressing()].value);
+			ext_bus_out_cb(DMEM[dmemAddressing<Core>()].value, CMEM[cmemAddressing<Core>()].value);
 		}
 		break;
 
 	default:
 		tms_printf("Unhandled 2nd instruction: %08X\n", insn);
-		if (UNKNOWN_STRICT) {
-			printf("Unhandled 2nd instruction: %08X\n", insn); //Always print if we hit the assert
-			assert(false);
+		if (Core::STRICT) {
+			printf("Unhandled 2nd instruction: %08X\n", insn); //Always print if we hit the fault
+			fault();
 		}
 		break;
 	}
 }
 
+template <class Core>
 void Emulator::execClass2() {
 	uint32_t original_insn = insn;
 
@@ -1434,13 +1467,14 @@ void Emulator::execClass2() {
 
 	insn &= 0x00003FFF; //Keep addressing stuff
 	insn |= translated_primary_instruction; //Merge in translated instruction
-	execPrimary();
+	execPrimary<Core>();
 
 	//Delete the first bit which makes this a class 2 instruction, so that it can be properly parsed by execPrimary
 	insn = original_insn & 0x7FFFFFFF;
 }
 
 //Returns CMEM address specified by the current instruction
+template <class Core>
 uint32_t Emulator::cmemAddressing() {
 	uint8_t mode = (insn >> 12) & 3;
 	bool ca_switch;
@@ -1476,9 +1510,10 @@ uint32_t Emulator::cmemAddressing() {
 		assert(false); //Should not happen
 	}
 
-	return cmemAddressing(addr);
+	return cmemAddressing<Core>(addr);
 }
 //Returns raw CMEM address of a requested CMEM address
+template <class Core>
 uint32_t Emulator::cmemAddressing(uint16_t addr) {
 	if (!CR1.LCMEM) {
 		addr += COFF.value;
@@ -1490,14 +1525,12 @@ uint32_t Emulator::cmemAddressing(uint16_t addr) {
 		addr &= 0xFF;
 	}
 
-	if (addr == 0x38) {
-		//printf("Instruction at %X accessed CMEM 38\n", PC.value);
-	}
-
+	Core::Hooks::access(*this, TraceTarget::CMEM, addr);
 	return addr;
 }
 
 //Returns DMEM address specified by the current instruction
+template <class Core>
 uint32_t Emulator::dmemAddressing() {
 	uint8_t mode = (insn >> 12) & 3;
 	bool ca_switch;
@@ -1525,9 +1558,10 @@ uint32_t Emulator::dmemAddressing() {
 		assert(false); //Should not happen
 	}
 
-	return dmemAddressing(addr);
+	return dmemAddressing<Core>(addr);
 }
 //Returns raw DMEM address of a requested DMEM address
+template <class Core>
 uint32_t Emulator::dmemAddressing(uint16_t addr) {
 	if (!CR1.LDMEM) {
 		addr += DOFF.value;
@@ -1539,10 +1573,23 @@ uint32_t Emulator::dmemAddressing(uint16_t addr) {
 		addr &= 0xFF;
 	}
 
+	Core::Hooks::access(*this, TraceTarget::DMEM, addr);
 	return addr;
 }
 
-uint32_t Emulator::xmemAddressing(uint32_t addr) {
+//Returns the number of cycles an XMEM access takes on the configured bus
+uint32_t Emulator::xmem_access_cycles() {
+	switch (CR3.XBUS) {
+	default:
+	case 0: return CR3.XWORD ? 21 : 15; //4-bit
+	case 1: return CR3.XWORD ? 12 : 9; //8-bit
+	case 2: return CR3.XWORD ? 9 : 0; //12-bit
+	case 3: return CR3.XWORD ? 0 : 6; //16-bit
+	}
+}
+
+//Returns the XMEM address mask for the configured bus and word size
+uint32_t Emulator::xmem_mask() {
 	uint32_t xmem_size;
 	switch (CR3.XBUS) {
 	default:
@@ -1554,11 +1601,18 @@ uint32_t Emulator::xmemAddressing(uint32_t addr) {
 	if (CR3.XWORD) {
 		xmem_size = xmem_size >> 1;
 	}
-	xmem_size--; //Convert size to bit mask
-	return (addr + XOFF) & xmem_size;
+	return xmem_size - 1; //Convert size to bit mask
+}
+
+template <class Core>
+uint32_t Emulator::xmemAddressing(uint32_t addr) {
+	addr = (addr + XOFF) & xmem_mask();
+	Core::Hooks::access(*this, TraceTarget::XMEM, addr);
+	return addr;
 }
 
 //Handle any jmp/call instruction
+template <class Core>
 void Emulator::execJmp() {
 	//Get the two nibbles after the first one. A jump instruction may be 0xF1800045 - in this case we want '18'
 	//Also AND with 7F to give jumps (0xF0 based) and calls (0xF8 based) the same conditions
@@ -1611,18 +1665,24 @@ void Emulator::execJmp() {
 		condition_pass = BIO;
 		break;
 	default:
-		if (UNKNOWN_STRICT) {
-			assert(false); //Unhandled jump type
+		if (Core::STRICT) {
+			fault(); //Unhandled jump type
 		}
 		break;
 	}
 	if (condition_pass) {
 		if (is_call) {
-			assert(SP != 4); //Stack overflow!
+			if (SP == 4) { //Stack overflow!
+				fault();
+				return;
+			}
 			stack[SP].value = PC.value;
 			SP++;
 		}
 
+		if (!is_call) {
+			Core::Hooks::branch(*this, target_address);
+		}
 		PC.value = target_address;
 
 		if (is_call)
@@ -1632,6 +1692,7 @@ void Emulator::execJmp() {
 	}
 }
 
+template <class Core>
 void Emulator::execPostIncrements() {
 	const uint8_t addrMode = (insn >> 12) & 3;
 	const uint8_t nibble2 = (insn >> 8) & 0xF; //Often referred to as 'i' in my notes
@@ -1699,4 +1760,21 @@ void Emulator::execPostIncrements() {
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+//The cores clock_cycle() dispatches to
+template void Emulator::execPrimary<StrictCore<false>>();
+template void Emulator::execPrimary<StrictCore<true>>();
+template void Emulator::execPrimary<LeanCore<false>>();
+template void Emulator::execPrimary<LeanCore<true>>();
+template void Emulator::execSecondary<StrictCore<false>>();
+template void Emulator::execSecondary<StrictCore<true>>();
+template void Emulator::execSecondary<LeanCore<false>>();
+template void Emulator::execSecondary<LeanCore<true>>();
+template void Emulator::execClass2<StrictCore<false>>();
+template void Emulator::execClass2<StrictCore<true>>();
+template void Emulator::execClass2<LeanCore<false>>();
+template void Emulator::execClass2<LeanCore<true>>();
+template void Emulator::execPostIncrements<StrictCore<false>>();
+template void Emulator::execPostIncrements<StrictCore<true>>();
+template void Emulator::execPostIncrements<LeanCore<false>>();
+template void Emulator::execPostIncrements<LeanCore<true>>();
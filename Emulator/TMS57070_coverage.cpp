@@ -0,0 +1,121 @@
+#include "TMS57070_coverage.h"
+#include "TMS57070_disasm.h"
+#include <cstring>
+#include <string>
+
+using namespace TMS57070;
+
+Coverage::Coverage() {
+	reset();
+}
+
+void Coverage::reset() {
+	memset(primary, 0, sizeof(primary));
+	memset(secondary, 0, sizeof(secondary));
+	memset(class2, 0, sizeof(class2));
+	memset(post_increments, 0, sizeof(post_increments));
+}
+
+uint64_t Coverage::primary_count(uint8_t opcode) const {
+	uint64_t count = 0;
+	for (int flags = 0; flags < 4; flags++) {
+		for (int mode = 0; mode < 4; mode++) {
+			count += primary[opcode][flags][mode];
+		}
+	}
+	return count;
+}
+
+uint64_t Coverage::secondary_count(uint8_t opcode) const {
+	uint64_t count = 0;
+	for (int args = 0; args < 4; args++) {
+		for (int mode = 0; mode < 4; mode++) {
+			count += secondary[opcode & 0x3F][args][mode];
+		}
+	}
+	return count;
+}
+
+//"+", "+CIR1" etc. as in execPostIncrements()
+static std::string increment_text(bool by_register, bool bit, const char* register_name) {
+	if (by_register) {
+		return std::string("+") + register_name + (bit ? "2" : "1");
+	}
+	return bit ? "+" : "";
+}
+
+static std::string post_increment_text(uint32_t key) {
+	uint32_t mode = key >> 8;
+	uint32_t nibble2 = (key >> 4) & 0xF;
+	uint32_t nibble1 = key & 0xF;
+	std::string text;
+	if (mode & 2) {
+		text += std::string("DA") + ((nibble2 & 8) ? "2" : "1") + increment_text(nibble2 & 4, nibble2 & 2, "DIR");
+	}
+	if (mode == 1) {
+		text += std::string("CA") + ((nibble2 & 8) ? "2" : "1") + increment_text(nibble2 & 4, nibble2 & 2, "CIR");
+	} else if (mode == 3) {
+		text += std::string(" CA") + ((nibble2 & 1) ? "2" : "1") + increment_text(nibble1 & 8, nibble1 & 4, "CIR");
+	}
+	return text.empty() ? "none" : text;
+}
+
+void Coverage::print(FILE* out) const {
+	//Examples are disassembled from a word with only the counted fields set
+	uint32_t variants = 0;
+	fprintf(out, "Primary instructions (opcode, flags, addressing mode):\n");
+	for (uint32_t opcode = 0; opcode < 256; opcode++) {
+		for (uint32_t flags = 0; flags < 4; flags++) {
+			for (uint32_t mode = 0; mode < 4; mode++) {
+				uint64_t count = primary[opcode][flags][mode];
+				if (!count) {
+					continue;
+				}
+				variants++;
+				uint32_t word = opcode << 24 | flags << 22 | (opcode < 0xC0 ? mode << 12 : 0);
+				disasm_t decoded = disassemble(word, 0);
+				fprintf(out, "  %02X %u %u  %12llu  %s%s%s\n", opcode, flags, mode, (unsigned long long)count, decoded.mnemonic,
+					decoded.operands.empty() ? "" : " ", decoded.operands.c_str());
+			}
+		}
+	}
+	fprintf(out, "  %u variants executed\n", variants);
+
+	variants = 0;
+	fprintf(out, "\nSecondary instructions (opcode, argument bits, addressing mode):\n");
+	for (uint32_t opcode = 0; opcode < 64; opcode++) {
+		for (uint32_t args = 0; args < 4; args++) {
+			for (uint32_t mode = 0; mode < 4; mode++) {
+				uint64_t count = secondary[opcode][args][mode];
+				if (!count) {
+					continue;
+				}
+				variants++;
+				disasm_t decoded = disassemble(opcode << 16 | args << 14 | mode << 12, 0);
+				fprintf(out, "  %02X %u %u  %12llu  %s\n", opcode, args, mode, (unsigned long long)count,
+					decoded.secondary.empty() ? "NOP" : decoded.secondary.c_str());
+			}
+		}
+	}
+	fprintf(out, "  %u variants executed\n", variants);
+
+	variants = 0;
+	fprintf(out, "\nClass 2 instructions:\n");
+	for (uint32_t opcode = 0; opcode < 64; opcode++) {
+		if (class2[opcode]) {
+			variants++;
+			fprintf(out, "  %02X      %12llu  %s\n", 0x80 | opcode, (unsigned long long)class2[opcode], disassemble((0x80 | opcode) << 24, 0).mnemonic);
+		}
+	}
+	fprintf(out, "  %u opcodes executed\n", variants);
+
+	variants = 0;
+	fprintf(out, "\nPost-increments (addressing mode, pointers):\n");
+	for (uint32_t key = 0; key < 1024; key++) {
+		if (post_increments[key]) {
+			variants++;
+			fprintf(out, "  %u       %12llu  %s\n", key >> 8, (unsigned long long)post_increments[key], post_increment_text(key).c_str());
+		}
+	}
+	fprintf(out, "  %u variants executed\n", variants);
+}
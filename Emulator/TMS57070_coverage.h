@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+namespace TMS57070 {
+
+	//Counts executed instructions by the fields the emulator decodes them with: primary opcodes with their
+	//two flag bits and addressing mode, secondary (class 1) opcodes with their argument bits and addressing mode, class 2 opcodes,
+	//and the post-increment modes of execPostIncrements(). Class 2 words count as both of the primary
+	//instructions execClass2() turns them into.
+	//Shows which emulator paths a program or test corpus exercises. Attach with Emulator::set_coverage()
+	class Coverage {
+	public:
+		Coverage();
+		void reset(); //Forget all counts
+
+		void count(uint32_t insn) { //Called for every instruction fetched
+			uint8_t opcode = insn >> 24;
+			if (opcode >= 0xC0) { //Only primary instruction, no addressing mode
+				primary[opcode][(insn >> 22) & 3][0]++;
+				return;
+			}
+			uint8_t mode = (insn >> 12) & 3;
+			if (opcode >= 0x80) { //Class 2: a 40-7F primary from the argument bits, then a 00-3F primary
+				class2[opcode & 0x3F]++;
+				primary[((insn >> 16) & 0x3F) + 0x40][(insn >> 14) & 3][mode]++;
+				primary[opcode & 0x7F][(insn >> 22) & 3][mode]++;
+			} else { //Class 1
+				secondary[(insn >> 16) & 0x3F][(insn >> 14) & 3][mode]++;
+				primary[opcode][(insn >> 22) & 3][mode]++;
+			}
+			post_increments[post_increment_key(insn)]++;
+		}
+
+		uint64_t primary_count(uint8_t opcode) const; //All flag and addressing variants
+		uint64_t secondary_count(uint8_t opcode) const;
+		uint64_t class2_count(uint8_t opcode) const { return class2[opcode & 0x3F]; }
+
+		void print(FILE* out) const; //Every executed variant, with its count and an example disassembly
+
+	private:
+		//Addressing mode and the nibble bits execPostIncrements() looks at in that mode
+		static uint32_t post_increment_key(uint32_t insn) {
+			static const uint8_t NIBBLE_MASKS[4] = { 0x00, 0xE0, 0xE0, 0xFC }; //nibble2 << 4 | nibble1
+			uint32_t mode = (insn >> 12) & 3;
+			return mode << 8 | ((insn >> 4) & NIBBLE_MASKS[mode]);
+		}
+
+		uint64_t primary[256][4][4]; //Opcode, flags (bit 0: 0x00400000, bit 1: 0x00800000), addressing mode
+		uint64_t secondary[64][4][4]; //Opcode, argument bits 15-14, addressing mode
+		uint64_t class2[64];
+		uint64_t post_increments[1024]; //post_increment_key()
+	};
+
+}
@@ -0,0 +1,137 @@
+#include "TMS57070_debugger.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint32_t WATCH_WORDS[3] = { 512, 512, 0x10000 }; //CMEM, DMEM, and the largest XMEM xmemAddressing() can address
+
+Debugger::Debugger() {
+	clear();
+}
+
+uint32_t Debugger::add_breakpoint(uint16_t pc, TraceReg reg, Compare compare, uint32_t value) {
+	breakpoints.push_back(breakpoint_t{ next_id, (uint16_t)(pc & 0x1FF), reg, compare, value });
+	rebuild();
+	return next_id++;
+}
+
+uint32_t Debugger::add_watchpoint(TraceTarget target, uint32_t addr, WatchKind kind) {
+	assert(target == TraceTarget::CMEM || target == TraceTarget::DMEM || target == TraceTarget::XMEM);
+	watchpoints.push_back(watchpoint_t{ next_id, target, addr, kind });
+	rebuild();
+	return next_id++;
+}
+
+void Debugger::remove(uint32_t id) {
+	breakpoints.erase(std::remove_if(breakpoints.begin(), breakpoints.end(), [id](const breakpoint_t& breakpoint) { return breakpoint.id == id; }), breakpoints.end());
+	watchpoints.erase(std::remove_if(watchpoints.begin(), watchpoints.end(), [id](const watchpoint_t& watchpoint) { return watchpoint.id == id; }), watchpoints.end());
+	rebuild();
+}
+
+void Debugger::clear() {
+	breakpoints.clear();
+	watchpoints.clear();
+	rebuild();
+	stop = false;
+	skip_pc = NO_PC;
+}
+
+void Debugger::set_callback(debug_callback_t cb, void* context) {
+	callback = cb;
+	callback_context = context;
+}
+
+void Debugger::resume() {
+	if (stop && !hit.watchpoint) {
+		skip_pc = hit.pc; //Let the instruction at the breakpoint execute
+	}
+	stop = false;
+}
+
+void Debugger::rebuild() {
+	memset(pc_breakpoints, 0, sizeof(pc_breakpoints));
+	for (const breakpoint_t& breakpoint : breakpoints) {
+		pc_breakpoints[breakpoint.pc] = 1;
+	}
+	for (uint32_t index = 0; index < 3; index++) {
+		watched[index].assign((WATCH_WORDS[index] + 63) / 64, 0);
+	}
+	watched_words = 0;
+	for (const watchpoint_t& watchpoint : watchpoints) {
+		uint32_t index = (uint32_t)watchpoint.target - (uint32_t)TraceTarget::CMEM;
+		if (watchpoint.addr < WATCH_WORDS[index]) {
+			watched[index][watchpoint.addr >> 6] |= 1ull << (watchpoint.addr & 63);
+			watched_words++;
+		}
+	}
+	pending_count = 0;
+}
+
+bool Debugger::breakpoint(uint16_t pc, uint64_t cycle, const uint32_t registers[TRACE_REG_COUNT]) {
+	bool stopping = false;
+	for (const breakpoint_t& breakpoint : breakpoints) {
+		if (breakpoint.pc != pc) {
+			continue;
+		}
+		uint32_t value = registers[(uint32_t)breakpoint.reg];
+		int32_t signed_value = (int32_t)(value << 8) >> 8;
+		int32_t signed_operand = (int32_t)(breakpoint.value << 8) >> 8;
+		bool condition = false;
+		switch (breakpoint.compare) {
+		case Compare::Always: condition = true; break;
+		case Compare::Equal: condition = value == breakpoint.value; break;
+		case Compare::NotEqual: condition = value != breakpoint.value; break;
+		case Compare::Less: condition = signed_value < signed_operand; break;
+		case Compare::Greater: condition = signed_value > signed_operand; break;
+		}
+		if (condition && report(debug_hit_t{ breakpoint.id, false, pc, cycle, TraceTarget::Instruction, 0, WatchKind::Access })) {
+			stopping = true;
+			break;
+		}
+	}
+	return stopping;
+}
+
+void Debugger::note(TraceTarget target, uint32_t addr, bool is_write) {
+	for (uint32_t index = 0; index < pending_count; index++) {
+		if (pending[index].target == target && pending[index].addr == addr) {
+			(is_write ? pending[index].writes : pending[index].accesses)++;
+			return;
+		}
+	}
+	if (pending_count < PENDING_MAX) {
+		pending[pending_count++] = pending_t{ target, addr, is_write ? 0u : 1u, is_write ? 1u : 0u };
+	}
+}
+
+void Debugger::report_accesses(uint16_t pc, uint64_t cycle) {
+	//Writes are counted where they land, and every write also computed its address, so reads are accesses minus writes
+	uint32_t count = pending_count;
+	pending_count = 0;
+	for (uint32_t index = 0; index < count; index++) {
+		const pending_t& access = pending[index];
+		bool read = access.accesses > access.writes;
+		bool written = access.writes != 0;
+		for (const watchpoint_t& watchpoint : watchpoints) {
+			if (watchpoint.target != access.target || watchpoint.addr != access.addr) {
+				continue;
+			}
+			if (written && ((uint8_t)watchpoint.kind & (uint8_t)WatchKind::Write)) {
+				report(debug_hit_t{ watchpoint.id, true, pc, cycle, access.target, access.addr, WatchKind::Write });
+			} else if (read && ((uint8_t)watchpoint.kind & (uint8_t)WatchKind::Read)) {
+				report(debug_hit_t{ watchpoint.id, true, pc, cycle, access.target, access.addr, WatchKind::Read });
+			}
+		}
+	}
+}
+
+bool Debugger::report(const debug_hit_t& new_hit) {
+	if (callback && !callback(new_hit, callback_context)) {
+		return false;
+	}
+	hit = new_hit;
+	stop = true;
+	return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	enum class WatchKind : uint8_t {
+		Read = 1,
+		Write = 2,
+		Access = 3, //Read or write
+	};
+
+	enum class Compare : uint8_t {
+		Always, //Unconditional breakpoint
+		Equal,
+		NotEqual,
+		Less, //Signed 24-bit
+		Greater,
+	};
+
+	struct debug_hit_t {
+		uint32_t id; //Of the breakpoint or watchpoint
+		bool watchpoint;
+		uint16_t pc; //Breakpoint: instruction about to execute. Watchpoint: instruction that made the access
+		uint64_t cycle;
+		TraceTarget target; //Watchpoints only
+		uint32_t addr;
+		WatchKind access; //Read or Write
+	};
+
+	//Return true to stop the run loop, false to continue
+	using debug_callback_t = bool(*)(const debug_hit_t& hit, void* context);
+
+	//PC breakpoints, optionally conditional on a register, and read/write watchpoints on CMEM/DMEM/XMEM words at
+	//their effective addresses. A breakpoint stops before its instruction executes, a watchpoint after the
+	//instruction that made the access. On a stop, run_until() and run_sample_period() return early, and
+	//run_block() returns with block.frames set to the frames that completed. Call resume() to continue
+	//from the stop. Attach with Emulator::set_debugger()
+	class Debugger {
+	public:
+		Debugger();
+
+		uint32_t add_breakpoint(uint16_t pc, TraceReg reg = TraceReg::ACC1, Compare compare = Compare::Always, uint32_t value = 0); //Registers as traced
+		uint32_t add_watchpoint(TraceTarget target, uint32_t addr, WatchKind kind);
+		void remove(uint32_t id);
+		void clear(); //Remove all breakpoints and watchpoints
+		void set_callback(debug_callback_t cb, void* context); //Called on every hit. Without a callback every hit stops
+
+		bool stopped() const { return stop; }
+		const debug_hit_t& last_hit() const { return hit; }
+		void resume(); //Continue after a stop. A breakpoint does not hit again before its instruction executed
+
+		//Emulator events
+		bool break_at(uint16_t pc) const { return pc_breakpoints[pc] && pc != skip_pc; }
+		bool breakpoint(uint16_t pc, uint64_t cycle, const uint32_t registers[TRACE_REG_COUNT]); //True if the run loop has to stop
+		void access(TraceTarget target, uint32_t addr) {
+			if (watched_words && is_watched(target, addr)) {
+				note(target, addr, false);
+			}
+		}
+		void write(TraceTarget target, uint32_t addr) {
+			if (watched_words && is_watched(target, addr)) {
+				note(target, addr, true);
+			}
+		}
+		void end_instruction(uint16_t pc, uint64_t cycle) { //Reports the watched accesses of the instruction
+			skip_pc = NO_PC;
+			if (pending_count) {
+				report_accesses(pc, cycle);
+			}
+		}
+
+	private:
+		static constexpr uint16_t NO_PC = 0xFFFF;
+		static constexpr uint32_t PENDING_MAX = 8;
+
+		struct breakpoint_t {
+			uint32_t id;
+			uint16_t pc;
+			TraceReg reg;
+			Compare compare;
+			uint32_t value;
+		};
+		struct watchpoint_t {
+			uint32_t id;
+			TraceTarget target;
+			uint32_t addr;
+			WatchKind kind;
+		};
+		struct pending_t {
+			TraceTarget target;
+			uint32_t addr;
+			uint32_t accesses; //Effective address computations
+			uint32_t writes;
+		};
+
+		bool is_watched(TraceTarget target, uint32_t addr) const {
+			const std::vector<uint64_t>& words = watched[(uint32_t)target - (uint32_t)TraceTarget::CMEM];
+			return (addr >> 6) < words.size() && (words[addr >> 6] >> (addr & 63) & 1);
+		}
+		void note(TraceTarget target, uint32_t addr, bool is_write);
+		void report_accesses(uint16_t pc, uint64_t cycle);
+		bool report(const debug_hit_t& new_hit);
+		void rebuild();
+
+		std::vector<breakpoint_t> breakpoints;
+		std::vector<watchpoint_t> watchpoints;
+		uint8_t pc_breakpoints[512]; //Any breakpoint at this PC
+		std::vector<uint64_t> watched[3]; //Word bitmaps of CMEM, DMEM, XMEM
+		uint32_t watched_words = 0;
+		pending_t pending[PENDING_MAX];
+		uint32_t pending_count = 0;
+		uint32_t next_id = 1;
+
+		debug_callback_t callback = nullptr;
+		void* callback_context = nullptr;
+		bool stop = false;
+		debug_hit_t hit{};
+		uint16_t skip_pc = NO_PC;
+	};
+
+}
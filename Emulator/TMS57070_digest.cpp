@@ -0,0 +1,87 @@
+#include "TMS57070_digest.h"
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint8_t DIGEST_MAGIC[4] = { 'T', '5', '7', 'D' };
+constexpr long DIGEST_HEADER_SIZE = 8;
+
+StateDigest::~StateDigest() {
+	close();
+}
+
+bool StateDigest::open(const char* path) {
+	close();
+	file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	if (!write_header()) {
+		fclose(file);
+		file = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void StateDigest::close() {
+	if (file) {
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+void StateDigest::sample(uint64_t cycle, const uint32_t registers[TRACE_REG_COUNT], uint32_t pc) {
+	uint64_t hash = digest_mix(memory ^ outputs);
+	for (uint32_t i = 0; i < TRACE_REG_COUNT; i++) {
+		hash = digest_mix(hash ^ ((uint64_t)i << 32 | registers[i]));
+	}
+	digest = digest_mix(hash ^ pc);
+	outputs = 0;
+	count++;
+
+	if (file) {
+		digest_entry_t entry{ cycle, digest };
+		fwrite(&entry, sizeof(entry), 1, file);
+	}
+}
+
+bool StateDigest::write_header() {
+	uint8_t header[DIGEST_HEADER_SIZE];
+	memcpy(header, DIGEST_MAGIC, 4);
+	header[4] = DIGEST_VERSION & 0xFF;
+	header[5] = DIGEST_VERSION >> 8;
+	header[6] = sizeof(digest_entry_t);
+	header[7] = 0;
+	return fwrite(header, 1, DIGEST_HEADER_SIZE, file) == DIGEST_HEADER_SIZE;
+}
+
+DigestReader::~DigestReader() {
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool DigestReader::open(const char* path) {
+	if (file) {
+		fclose(file);
+	}
+	file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	uint8_t header[DIGEST_HEADER_SIZE];
+	if (fread(header, 1, DIGEST_HEADER_SIZE, file) != DIGEST_HEADER_SIZE
+		|| memcmp(header, DIGEST_MAGIC, 4) != 0
+		|| (header[4] | header[5] << 8) != DIGEST_VERSION
+		|| header[6] != sizeof(digest_entry_t)) {
+		fclose(file);
+		file = nullptr;
+		return false;
+	}
+	return true;
+}
+
+size_t DigestReader::read(digest_entry_t* entries, size_t count) {
+	return file ? fread(entries, sizeof(digest_entry_t), count, file) : 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	constexpr uint16_t DIGEST_VERSION = 1;
+
+	struct digest_entry_t {
+		uint64_t cycle; //Cycle at the end of the sample period
+		uint64_t digest;
+	};
+	static_assert(sizeof(digest_entry_t) == 16, "digest_entry_t is a file format");
+
+	//SplitMix64 finalizer
+	inline uint64_t digest_mix(uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	//Hash of one memory word. Zero words hash to zero, so memory that was never written costs nothing to hash
+	inline uint64_t digest_word(TraceTarget target, uint32_t addr, uint32_t value) {
+		value &= 0xFFFFFF;
+		return value ? digest_mix((uint64_t)target << 56 | (uint64_t)(addr & 0xFFFFFF) << 32 | value) : 0;
+	}
+
+	//64-bit hash of the architectural state and the audio output at each sample boundary.
+	//The memory part is the XOR of digest_word() over all CMEM/DMEM/XMEM words, so each write updates it
+	//in constant time instead of rehashing the memories. Registers and outputs are few and are hashed per sample.
+	//Equal digests mean equal state with overwhelming probability; comparing two digest files finds the first sample
+	//at which two runs diverge (see TraceDiffer::compare_digests)
+	class StateDigest {
+	public:
+		~StateDigest();
+		bool open(const char* path); //Append every sample's digest to a file
+		void close();
+
+		void set_memory(uint64_t hash) { memory = hash; } //Start from a full hash of the memories
+		void write(TraceTarget target, uint32_t addr, int32_t old_value, int32_t new_value) {
+			memory ^= digest_word(target, addr, (uint32_t)old_value) ^ digest_word(target, addr, (uint32_t)new_value);
+		}
+		void output(uint32_t channel, int32_t value) {
+			outputs = digest_mix(outputs ^ ((uint64_t)channel << 32 | ((uint32_t)value & 0xFFFFFF)));
+		}
+		void sample(uint64_t cycle, const uint32_t registers[TRACE_REG_COUNT], uint32_t pc); //Close a sample period
+
+		uint64_t last() const { return digest; } //Digest of the last sample
+		uint64_t samples() const { return count; }
+
+	private:
+		bool write_header();
+
+		uint64_t memory = 0;
+		uint64_t outputs = 0; //Output samples of the current sample period, in order
+		uint64_t digest = 0;
+		uint64_t count = 0;
+		FILE* file = nullptr;
+	};
+
+	//Reads digest files written by StateDigest
+	class DigestReader {
+	public:
+		~DigestReader();
+		bool open(const char* path);
+		size_t read(digest_entry_t* entries, size_t count); //Returns the number of entries read
+
+	private:
+		FILE* file = nullptr;
+	};
+
+}
@@ -0,0 +1,11 @@
+#include "TMS57070_dirty.h"
+
+using namespace TMS57070;
+
+DirtyMap::DirtyMap(uint32_t words) {
+	uint32_t size = words;
+	do {
+		size = (size + 63) >> 6;
+		levels.emplace_back(size, 0);
+	} while (size > 1);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace TMS57070 {
+
+	//Which words of a memory were written since they were last collected.
+	//One bit per word, and above that one bit per bitmap word at each level up to a single top word,
+	//so finding the dirty words of even the 16M word XMEM only visits bitmap words that have bits set.
+	//Collecting clears exactly the bits it visits, so its cost follows the number of dirty words, not the memory size
+	class DirtyMap {
+	public:
+		DirtyMap(uint32_t words);
+
+		void mark(uint32_t addr) {
+			for (std::vector<uint64_t>& level : levels) {
+				uint64_t& word = level[addr >> 6];
+				uint64_t bit = 1ull << (addr & 63);
+				if (word & bit) {
+					return; //Already marked, and so are the levels above
+				}
+				word |= bit;
+				addr >>= 6;
+			}
+		}
+		bool is_dirty(uint32_t addr) const { return (levels[0][addr >> 6] >> (addr & 63)) & 1; }
+		bool any() const { return levels.back()[0] != 0; }
+
+		//Calls f(addr) for every dirty word in ascending order, and clears them
+		template <typename F>
+		void collect(F f) {
+			collect((uint32_t)levels.size() - 1, 0, f);
+		}
+		void clear() { collect([](uint32_t) {}); }
+
+	private:
+		template <typename F>
+		void collect(uint32_t level, uint32_t index, F& f) {
+			uint64_t& word = levels[level][index];
+			while (word) {
+				uint32_t bit = ctz64(word);
+				word &= word - 1;
+				uint32_t child = index << 6 | bit;
+				if (level == 0) {
+					f(child);
+				} else {
+					collect(level - 1, child, f);
+				}
+			}
+		}
+
+		static uint32_t ctz64(uint64_t value) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return index;
+#else
+			return (uint32_t)__builtin_ctzll(value);
+#endif
+		}
+
+		std::vector<std::vector<uint64_t>> levels; //levels[0] has one bit per word, the last level is a single word
+	};
+
+	//Dirty words of the data memories. Attach with Emulator::set_dirty_tracker()
+	struct DirtyTracker {
+		DirtyMap CMEM{ 512 };
+		DirtyMap DMEM{ 512 };
+		DirtyMap XMEM{ 0xFFFFFF };
+	};
+
+}
@@ -0,0 +1,795 @@
+#include "TMS57070_disasm.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace TMS57070;
+
+//Port of the instruction analysis in TMS57070_disasm.py (notify_ana and the ana_* functions),
+//so that listings from the emulator and from IDA read the same
+
+namespace {
+
+	enum class OperandType {
+		Void,
+		Reg,
+		Imm,
+		Near, //PMEM address
+		Mem, //Direct CMEM/DMEM address
+	};
+
+	struct operand_t {
+		OperandType type = OperandType::Void;
+		const char* reg = "";
+		int32_t value = 0; //Immediate or address
+		bool pointer = false; //Register is used as a pointer: *CA1
+		bool post_increment = false; //*CA1+
+		const char* increment_reg = nullptr; //*CA1+CIR1
+		bool negate = false;
+		bool signed_imm = false;
+		const char* shift = nullptr; //SHACC/SHMAC direction
+		const char* memory = nullptr; //CMEM or DMEM
+		const char* secondary = nullptr; //Secondary instruction mnemonic, instead of MOV
+	};
+
+	class Decoder {
+	public:
+		Decoder(uint32_t word, uint16_t pc);
+		disasm_t result();
+
+	private:
+		void ana_jumps();
+		void ana_lri_long();
+		void ana_lri();
+		void ana_lri_dual();
+		void ana_lri_circ();
+		void ana_dmem_addressing(int operand);
+		void ana_cmem_addressing(int operand);
+		void ana_load(const char* mnemonic);
+		void ana_programword();
+		void ana_repeat();
+		void ana_shift(const char* mnemonic, const char* reg1, const char* reg2);
+		void ana_dmov();
+		void ana_zacc();
+		void ana_zmacc();
+		void ana_arith(const char* mnemonic);
+		void ana_arith_dual(const char* mnemonic);
+		void ana_mult_single();
+		void ana_mult_cmem(const char* mnemonic);
+		void ana_mult_dmem(const char* mnemonic);
+		void ana_mult_dual(const char* mnemonic);
+		void ana_extern();
+		void ana_loadmacc(const char* mnemonic);
+		void ana_cmp();
+		void ana2();
+		void ana2_store(const char* reg1, const char* reg2);
+		void ana2_store_cmem(const char* reg1, const char* reg2, const char* reg3, const char* reg4);
+		void ana2_load_cmem(const char* reg1, const char* reg2, const char* reg3, const char* reg4);
+		void ana2_load_acc(const char* reg1, const char* reg2);
+		void ana2_dereference();
+		void ana2_input();
+		void ana2_output();
+		void ana2_21();
+		void ana2_CR();
+		void ana2_hir();
+		void ana2_advance();
+		void ana2_mode(const char* reg, int32_t value, bool signed_value);
+		void ana2_2C();
+		void ana2_noise();
+		void set_reg(int operand, const char* reg);
+		void set_imm(int operand, int32_t value);
+		void set_secondary(const char* mnemonic);
+		void set_unknown_secondary();
+		std::string format(const operand_t& op);
+
+		uint32_t word;
+		uint16_t pc;
+		uint8_t b1, b2, b3, b4;
+		uint8_t opcode2;
+		const char* mnemonic = "UNKN";
+		operand_t ops[6]; //0-3: primary instruction, 4-5: secondary instruction
+	};
+
+	const char* pick(bool second, const char* reg1, const char* reg2) {
+		return second ? reg2 : reg1;
+	}
+
+}
+
+Decoder::Decoder(uint32_t word, uint16_t pc) {
+	this->word = word;
+	this->pc = pc;
+	b1 = word >> 24;
+	b2 = word >> 16;
+	b3 = word >> 8;
+	b4 = word;
+	opcode2 = b2 & 0x3F; //2 MSBs of byte 2 are args
+
+	uint8_t opcode1 = b1;
+	if (opcode1 == 0x00) {
+		mnemonic = "NOP";
+	} else if (opcode1 >= 0x04 && opcode1 <= 0x07) {
+		ana_load("LACCU");
+	} else if (opcode1 >= 0x08 && opcode1 <= 0x0B) {
+		ana_load("CPML");
+	} else if (opcode1 >= 0x10 && opcode1 <= 0x13) {
+		ana_load("LACC");
+	} else if (opcode1 >= 0x14 && opcode1 <= 0x17) {
+		ana_load("INC");
+	} else if (opcode1 >= 0x18 && opcode1 <= 0x1B) {
+		ana_load("DEC");
+	} else if (opcode1 == 0x1C) {
+		ana_shift("SHACC", "ACC1", "ACC2");
+	} else if (opcode1 == 0x1E) {
+		ana_dmov();
+	} else if (opcode1 == 0x1D || opcode1 == 0x1F) {
+		ana_zacc();
+	} else if (opcode1 >= 0x20 && opcode1 <= 0x23) {
+		ana_arith("ADD");
+	} else if (opcode1 >= 0x24 && opcode1 <= 0x27) {
+		ana_arith("SUB");
+	} else if (opcode1 >= 0x28 && opcode1 <= 0x2B) {
+		ana_arith("AND");
+	} else if (opcode1 >= 0x2C && opcode1 <= 0x2F) {
+		ana_arith("OR");
+	} else if (opcode1 >= 0x30 && opcode1 <= 0x33) {
+		ana_arith("XOR");
+	} else if (opcode1 >= 0x34 && opcode1 <= 0x37) {
+		ana_cmp();
+	} else if (opcode1 == 0x39) {
+		ana_extern();
+	} else if (opcode1 == 0x3C) {
+		ana_arith_dual("ADDD");
+	} else if (opcode1 == 0x3D) {
+		ana_arith_dual((b2 & 0x80) ? "ORD" : "ANDD");
+	} else if (opcode1 == 0x3E) {
+		ana_arith_dual("XORD");
+	} else if (opcode1 == 0x40 || opcode1 == 0x41) {
+		ana_mult_cmem("MPY(1)");
+	} else if (opcode1 == 0x44 || opcode1 == 0x45) {
+		ana_mult_cmem("MPY(2)");
+	} else if (opcode1 == 0x48 || opcode1 == 0x49) {
+		ana_mult_cmem("MPY(3)");
+	} else if (opcode1 == 0x4C || opcode1 == 0x4D) {
+		ana_mult_cmem("MPY(4)");
+	} else if (opcode1 == 0x42) {
+		ana_mult_dual("MPY(5)");
+	} else if (opcode1 == 0x46) {
+		ana_mult_dual("MPY(6)");
+	} else if (opcode1 == 0x4A) {
+		ana_mult_dual("MPY(7)");
+	} else if (opcode1 == 0x4E) {
+		ana_mult_dual("MPY(8)");
+	} else if (opcode1 == 0x50 || opcode1 == 0x51) {
+		ana_mult_cmem("MAC(1)");
+	} else if (opcode1 == 0x52 || opcode1 == 0x53) {
+		ana_mult_dmem("MAC(2)");
+	} else if (opcode1 == 0x54 || opcode1 == 0x55) {
+		ana_mult_cmem("MAC(3)");
+	} else if (opcode1 == 0x56 || opcode1 == 0x57) {
+		ana_mult_dmem("MAC(4)");
+	} else if (opcode1 == 0x58 || opcode1 == 0x59) {
+		ana_mult_cmem("MAC(5)");
+	} else if (opcode1 == 0x5A || opcode1 == 0x5B) {
+		ana_mult_dmem("MAC(6)");
+	} else if (opcode1 == 0x5C || opcode1 == 0x5D) {
+		ana_mult_cmem("MAC(7)");
+	} else if (opcode1 == 0x5E || opcode1 == 0x5F) {
+		ana_mult_dmem("MAC(8)");
+	} else if (opcode1 == 0x60 || opcode1 == 0x61) {
+		ana_mult_cmem("MACl(1)");
+	} else if (opcode1 == 0x62 || opcode1 == 0x63) {
+		ana_mult_dmem("MACl(2)");
+	} else if (opcode1 == 0x64 || opcode1 == 0x65) {
+		ana_mult_cmem("MACl(3)");
+	} else if (opcode1 == 0x66 || opcode1 == 0x67) {
+		ana_mult_dmem("MACl(4)");
+	} else if (opcode1 == 0x6C) {
+		ana_mult_dual("MAC(9)");
+	} else if (opcode1 == 0x6D) {
+		ana_mult_dual("MAC(A)");
+	} else if (opcode1 == 0x6E) {
+		ana_mult_dual("MAC(B)");
+	} else if (opcode1 == 0x6F) {
+		ana_mult_dual("MAC(C)");
+	} else if (opcode1 == 0x70) {
+		ana_mult_dual("MACl(5)");
+	} else if (opcode1 == 0x71) {
+		ana_mult_dual("MACl(6)");
+	} else if (opcode1 == 0x72) {
+		ana_shift("SHMAC", "MACC1", "MACC2");
+	} else if ((opcode1 == 0x73 || opcode1 == 0x74) && b2 < 0x80) {
+		ana_zmacc();
+	} else if (opcode1 == 0x78 || opcode1 == 0x79) {
+		ana_loadmacc("LMH");
+	} else if (opcode1 == 0x7A || opcode1 == 0x7B) {
+		ana_loadmacc("LMHC");
+	} else if (opcode1 == 0x7C || opcode1 == 0x7D) {
+		ana_loadmacc("LML");
+	} else if (opcode1 == 0xC1) {
+		ana_lri();
+	} else if (opcode1 >= 0xC2 && opcode1 <= 0xC6) {
+		ana_lri_dual();
+	} else if (opcode1 == 0xC7 || opcode1 == 0xC8) {
+		ana_lri_circ();
+	} else if (opcode1 >= 0xCA && opcode1 <= 0xCF) {
+		ana_lri_long();
+	} else if (opcode1 == 0xD8 || opcode1 == 0xD9) {
+		ana_programword();
+	} else if (opcode1 == 0xE0 || opcode1 == 0xE2 || opcode1 == 0xE3 || opcode1 == 0xE4) {
+		ana_repeat();
+	} else if (opcode1 == 0xEC) {
+		mnemonic = "RET";
+	} else if (opcode1 == 0xEE) {
+		mnemonic = "RETI";
+	} else if (opcode1 >= 0xF0) {
+		ana_jumps();
+	}
+
+	if (strcmp(mnemonic, "UNKN") == 0) {
+		ops[0] = operand_t();
+		set_imm(0, word);
+	}
+
+	//Secondary instruction
+	if (opcode1 <= 0x7F) {
+		ana2();
+	}
+}
+
+void Decoder::set_reg(int operand, const char* reg) {
+	ops[operand].type = OperandType::Reg;
+	ops[operand].reg = reg;
+}
+
+void Decoder::set_imm(int operand, int32_t value) {
+	ops[operand].type = OperandType::Imm;
+	ops[operand].value = value;
+}
+
+void Decoder::set_secondary(const char* secondary) {
+	ops[4].type = OperandType::Reg;
+	ops[4].reg = "";
+	ops[4].secondary = secondary;
+}
+
+void Decoder::set_unknown_secondary() {
+	set_reg(4, "unkn");
+	set_reg(5, "unkn");
+}
+
+void Decoder::ana_jumps() {
+	ops[0].type = OperandType::Near;
+	ops[0].value = (b3 & 1) << 8 | b4;
+
+	uint8_t condition = (b1 & 0x7) << 4 | b2 >> 4;
+	bool call = b1 >= 0xF8;
+	switch (condition) {
+	case 0x00: mnemonic = call ? "CALL" : "JMP"; break;
+	case 0x08: mnemonic = call ? "CALL" : "JMP"; set_reg(0, "ACC1"); break; //Indirect
+	case 0x0C: mnemonic = call ? "CALL" : "JMP"; set_reg(0, "ACC2"); break;
+	case 0x10: mnemonic = call ? "CZ" : "JZ"; break;
+	case 0x18: mnemonic = call ? "CNZ" : "JNZ"; break;
+	case 0x20: mnemonic = call ? "CGZ" : "JGZ"; break;
+	case 0x28: mnemonic = call ? "CLZ" : "JLZ"; break;
+	case 0x30: mnemonic = call ? "CAOV" : "JAOV"; break;
+	case 0x48: mnemonic = call ? "CMOV" : "JMOV"; break;
+	case 0x58: mnemonic = call ? "CBIOZ" : "JBIOZ"; break;
+	default: mnemonic = call ? "CUNKN" : "JUNKN"; break;
+	}
+}
+
+void Decoder::ana_lri_long() {
+	static const char* REGS[] = { "ACC1", "ACC2", "CR0", "CR1", "CR2", "CR3" };
+	mnemonic = "LRI";
+	set_imm(0, b2 << 16 | b3 << 8 | b4);
+	set_reg(1, REGS[b1 - 0xCA]);
+}
+
+void Decoder::ana_lri() {
+	static const char* REGS[] = { "DA1", "DA2", "DIR1", "DIR2", "CA1", "CA2", "CIR1", "CIR2", "CA1", "CA2" };
+	mnemonic = "LRI";
+	set_imm(0, (b3 & 0xF) << 8 | b4);
+	if ((b2 & 7) == 0 && (b2 >> 3) < 10) {
+		set_reg(1, REGS[b2 >> 3]);
+		if (b2 >= 0x40) {
+			mnemonic = "LRIAE";
+			set_reg(2, "ACC");
+		}
+	}
+}
+
+void Decoder::ana_lri_dual() {
+	mnemonic = "LRI";
+	set_imm(0, b4 | (b3 & 0xF) << 8);
+	set_imm(1, b3 >> 4 | b2 << 4);
+	switch (b1) {
+	case 0xC2: set_reg(2, "DA"); break;
+	case 0xC3: set_reg(2, "DIR"); break;
+	case 0xC4: set_reg(2, "CA"); break;
+	case 0xC5: set_reg(2, "CIR"); break;
+	case 0xC6:
+		mnemonic = "LRIAE";
+		set_reg(2, "CA");
+		set_reg(3, "ACC");
+		break;
+	}
+}
+
+void Decoder::ana_lri_circ() {
+	bool cmem = b1 == 0xC8;
+	mnemonic = "LRI";
+	set_imm(0, b3 >> 4 | b2 << 4);
+	set_reg(1, cmem ? "CCIRC" : "DCIRC");
+	set_imm(2, b4 | (b3 & 0xF) << 8);
+	set_reg(3, cmem ? "COFF" : "DOFF");
+}
+
+void Decoder::ana_dmem_addressing(int operand) {
+	operand_t& op = ops[operand];
+	uint8_t arg = b3 & 0x30;
+	if (arg == 0x30 || arg == 0x20) {
+		op.type = OperandType::Reg;
+		op.pointer = true;
+		op.reg = pick(b3 & 8, "DA1", "DA2");
+		if (b3 & 4) {
+			op.post_increment = true;
+			op.increment_reg = pick(b3 & 2, "DIR1", "DIR2");
+		} else {
+			op.post_increment = (b3 & 2) != 0;
+		}
+	} else if (arg == 0x10) {
+		op.type = OperandType::Mem;
+		op.value = (b3 & 1) << 8 | b4;
+		op.memory = "DMEM";
+	}
+}
+
+void Decoder::ana_cmem_addressing(int operand) {
+	operand_t& op = ops[operand];
+	uint8_t arg = b3 & 0x30;
+	if (arg == 0x30) {
+		op.type = OperandType::Reg;
+		op.pointer = true;
+		op.reg = pick(b3 & 1, "CA1", "CA2");
+		if (b4 & 0x80) {
+			op.post_increment = true;
+			op.increment_reg = pick(b4 & 0x40, "CIR1", "CIR2");
+		} else {
+			op.post_increment = (b4 & 0x40) != 0;
+		}
+	} else if (arg == 0x10) {
+		op.type = OperandType::Reg;
+		op.pointer = true;
+		op.reg = pick(b3 & 8, "CA1", "CA2");
+		if (b3 & 4) {
+			op.post_increment = true;
+			op.increment_reg = pick(b3 & 2, "CIR1", "CIR2");
+		} else {
+			op.post_increment = (b3 & 2) != 0;
+		}
+	} else if (arg == 0x20) {
+		op.type = OperandType::Mem;
+		op.value = (b3 & 1) << 8 | b4;
+		op.memory = "CMEM";
+	} else {
+		set_reg(operand, "unkn");
+	}
+}
+
+void Decoder::ana_load(const char* name) {
+	mnemonic = name;
+	set_reg(1, pick(b2 & 0x40, "ACC1", "ACC2"));
+	switch (b1 & 3) {
+	case 0: ana_dmem_addressing(0); break;
+	case 1: ana_cmem_addressing(0); break;
+	case 2: set_reg(0, pick(b2 & 0x80, "ACC1", "ACC2")); break;
+	case 3: set_reg(0, pick(b2 & 0x80, "MACC1", "MACC2")); break;
+	}
+}
+
+void Decoder::ana_programword() {
+	mnemonic = "PW";
+	set_reg(0, pick(b1 == 0xD9, "ACC1", "ACC2"));
+}
+
+void Decoder::ana_repeat() {
+	mnemonic = "RPTK";
+	set_imm(0, b2);
+	ops[1].type = OperandType::Near;
+	ops[1].value = (pc + 1) & 0x1FF;
+	if (b1 == 0xE2) {
+		set_reg(0, "ACC1");
+	} else if (b1 == 0xE3) {
+		set_reg(0, "ACC2");
+	} else if (b1 == 0xE4) {
+		mnemonic = "RPTB";
+		ops[1].value = (b3 & 1) << 8 | b4;
+	}
+}
+
+void Decoder::ana_shift(const char* name, const char* reg1, const char* reg2) {
+	mnemonic = name;
+	set_reg(0, pick(b2 & 0x40, reg1, reg2));
+	ops[0].shift = (b2 & 0x80) ? "<<" : ">>";
+}
+
+void Decoder::ana_dmov() {
+	mnemonic = "DMOV";
+	if (!(b2 & 0x40)) {
+		//Move dual MACC to ACC
+		set_reg(0, pick(b2 & 0x80, "MACC1", "MACC2"));
+		set_reg(1, "ACC2");
+		set_reg(2, pick(b2 & 0x80, "MACC1L", "MACC2L"));
+		set_reg(3, "ACC1");
+	}
+}
+
+void Decoder::ana_zacc() {
+	mnemonic = "ZACC";
+	if (b1 == 0x1D) {
+		set_reg(0, pick(b2 & 0x40, "ACC1", "ACC2"));
+	} else {
+		set_reg(0, "ACC1");
+		set_reg(1, "ACC2");
+	}
+}
+
+void Decoder::ana_zmacc() {
+	mnemonic = "ZMACC";
+	if (b1 == 0x73) {
+		set_reg(0, pick(b2 & 0x40, "MACC1", "MACC2"));
+	} else {
+		set_reg(0, "MACC1");
+		set_reg(1, "MACC2");
+	}
+}
+
+void Decoder::ana_arith(const char* name) {
+	mnemonic = name;
+	uint8_t op = b1 & 3;
+	if (op <= 1) {
+		ana_dmem_addressing(0);
+	} else {
+		ana_cmem_addressing(0);
+	}
+	if (op == 0 || op == 2) {
+		set_reg(1, pick(b2 & 0x80, "ACC1", "ACC2"));
+	} else {
+		set_reg(1, pick(b2 & 0x80, "MACC1", "MACC2"));
+	}
+	set_reg(2, pick(b2 & 0x40, "ACC1", "ACC2"));
+}
+
+void Decoder::ana_arith_dual(const char* name) {
+	mnemonic = name;
+	ana_cmem_addressing(0);
+	ana_dmem_addressing(1);
+	if (b1 == 0x3C && (b2 & 0x80)) {
+		ops[0].negate = true;
+	}
+	set_reg(2, pick(b2 & 0x40, "ACC1", "ACC2"));
+}
+
+void Decoder::ana_mult_single() {
+	set_reg(2, pick(b1 & 1, "ACC1", "ACC2"));
+	ops[2].negate = (b2 & 0x80) != 0;
+	set_reg(3, pick(b2 & 0x40, "MACC1", "MACC2"));
+}
+
+void Decoder::ana_mult_cmem(const char* name) {
+	mnemonic = name;
+	const char* signs = "SS";
+	switch (b1 & ~1) {
+	case 0x44: case 0x54: signs = "US"; break;
+	case 0x48: case 0x58: signs = "SU"; break;
+	case 0x4C: case 0x5C: signs = "UU"; break;
+	case 0x64: signs = "US"; break;
+	}
+	set_reg(0, signs);
+	ana_cmem_addressing(1);
+	ana_mult_single();
+}
+
+void Decoder::ana_mult_dmem(const char* name) {
+	mnemonic = name;
+	const char* signs = "SS";
+	switch (b1 & ~1) {
+	case 0x56: signs = "SU"; break;
+	case 0x5A: signs = "US"; break;
+	case 0x5E: signs = "UU"; break;
+	case 0x66: signs = "SU"; break;
+	}
+	set_reg(0, signs);
+	ana_dmem_addressing(1);
+	ana_mult_single();
+}
+
+void Decoder::ana_mult_dual(const char* name) {
+	mnemonic = name;
+	const char* signs = "SS";
+	switch (b1) {
+	case 0x46: case 0x6D: case 0x71: signs = "US"; break;
+	case 0x4A: case 0x6E: signs = "SU"; break;
+	case 0x4E: case 0x6F: signs = "UU"; break;
+	}
+	set_reg(0, signs);
+	ana_cmem_addressing(1);
+	ana_dmem_addressing(2);
+	ops[1].negate = (b2 & 0x80) != 0;
+	set_reg(3, pick(b2 & 0x40, "MACC1", "MACC2"));
+}
+
+void Decoder::ana_extern() {
+	if (b2 & 0x40) {
+		mnemonic = "WRE";
+		ana_dmem_addressing(0);
+		ana_cmem_addressing(1);
+	} else {
+		mnemonic = "RDE";
+		ana_cmem_addressing(0);
+		set_reg(1, "XRD");
+	}
+}
+
+void Decoder::ana_loadmacc(const char* name) {
+	mnemonic = name;
+	if (b2 & 0x80) {
+		set_reg(0, pick(b1 & 1, "ACC1", "ACC2"));
+	} else if (b1 & 1) {
+		ana_cmem_addressing(0);
+	} else {
+		ana_dmem_addressing(0);
+	}
+	set_reg(1, pick(b2 & 0x40, "MACC1", "MACC2"));
+}
+
+void Decoder::ana_cmp() {
+	if (b1 & 2) {
+		ana_cmem_addressing(0);
+	} else {
+		ana_dmem_addressing(0);
+	}
+	if (b1 & 1) {
+		mnemonic = "CMP(2)";
+		set_reg(1, pick(b2 & 0x80, "MACC1", "MACC2"));
+	} else {
+		mnemonic = "CMP(1)";
+		set_reg(1, pick(b2 & 0x80, "ACC1", "ACC2"));
+	}
+}
+
+void Decoder::ana2() {
+	switch (opcode2) {
+	case 0x00: break;
+	case 0x01: ana2_store("ACC1", "ACC2"); break;
+	case 0x02: ana2_store("MACC1", "MACC2"); break;
+	case 0x03: ana2_store("MACC1L", "MACC2L"); break;
+	case 0x04: ana2_load_acc("DA1", "DA2"); break;
+	case 0x05: ana2_load_acc("CA1", "CA2"); break;
+	case 0x06: ana2_load_cmem("DA", "DIR", "CA", "CIR"); break;
+	case 0x07: ana2_store_cmem("DA", "DIR", "CA", "CIR"); break;
+	case 0x08: case 0x09: ana2_dereference(); break;
+	case 0x0A: ana2_store_cmem("DA1", "DIR1", "DA2", "DIR2"); break;
+	case 0x0B: ana2_store_cmem("CA1", "CIR1", "CA2", "CIR2"); break;
+	case 0x0C: case 0x0D: ana2_input(); break;
+	case 0x18: case 0x19: case 0x1A: ana2_output(); break;
+	case 0x20:
+		set_reg(4, "XRD");
+		ana_dmem_addressing(5);
+		break;
+	case 0x21: ana2_21(); break;
+	case 0x22: case 0x23: ana2_CR(); break;
+	case 0x26: ana2_hir(); break;
+	case 0x27: ana2_advance(); break;
+	case 0x28: {
+		static const int32_t MODES[] = { 0, 2, 4, -24 };
+		ana2_mode("CR1.MASM", MODES[b3 >> 6], true);
+	} break;
+	case 0x29: {
+		static const int32_t MODES[] = { 0, 2, 4, -8 };
+		ana2_mode("CR1.MOSM", MODES[b3 >> 6], true);
+	} break;
+	case 0x2A: case 0x2B: {
+		static const int32_t MODES[] = { 48, 24, 20, 18, 16, 16, 20, 18 };
+		ana2_mode("CR1.MRDM", MODES[(b3 >> 6) + (opcode2 == 0x2B ? 4 : 0)], false);
+	} break;
+	case 0x2C: ana2_2C(); break;
+	case 0x2D: ana2_mode((b3 >> 6) <= 1 ? "CR1.AOVM" : "CR1.MOVM", (b3 >> 6) & 1, false); break;
+	case 0x2E: ana2_mode((b3 & 0x80) ? "CR1.LCMEM" : "CR1.LDMEM", (b3 >> 6) & 1, false); break;
+	case 0x34: ana2_noise(); break;
+	default: set_unknown_secondary(); break;
+	}
+}
+
+void Decoder::ana2_store(const char* reg1, const char* reg2) {
+	set_reg(4, pick(b3 & 0x40, reg1, reg2));
+	if (b3 & 0x80) {
+		ana_cmem_addressing(5);
+	} else {
+		ana_dmem_addressing(5);
+	}
+}
+
+void Decoder::ana2_store_cmem(const char* reg1, const char* reg2, const char* reg3, const char* reg4) {
+	const char* regs[] = { reg1, reg2, reg3, reg4 };
+	set_reg(4, regs[b3 >> 6]);
+	ana_cmem_addressing(5);
+}
+
+void Decoder::ana2_load_cmem(const char* reg1, const char* reg2, const char* reg3, const char* reg4) {
+	const char* regs[] = { reg1, reg2, reg3, reg4 };
+	set_reg(5, regs[b3 >> 6]);
+	ana_cmem_addressing(4);
+}
+
+void Decoder::ana2_load_acc(const char* reg1, const char* reg2) {
+	uint8_t arg = b3 >> 6;
+	set_reg(4, pick(arg & 1, "ACC1", "ACC2"));
+	set_reg(5, pick(arg & 2, reg1, reg2));
+}
+
+void Decoder::ana2_dereference() {
+	static const char* CMEM_REGS[] = { "CA1", "CA2", "CIR1", "CIR2" };
+	static const char* DMEM_REGS[] = { "DA1", "DA2", "DIR1", "DIR2" };
+	ana_cmem_addressing(4);
+	const char** regs = (opcode2 == 0x09) ? CMEM_REGS : DMEM_REGS;
+	set_reg(5, regs[((b3 & 0x40) ? 2 : 0) + ((b3 & 0x80) ? 1 : 0)]);
+}
+
+void Decoder::ana2_input() {
+	static const char* REGS[] = { "AR1L", "AR1R", "AR2L", "AR2R" };
+	set_reg(4, REGS[(opcode2 == 0x0D ? 2 : 0) + ((b3 & 0x80) ? 1 : 0)]);
+	ana_dmem_addressing(5);
+}
+
+void Decoder::ana2_output() {
+	static const char* REGS[] = { "AX1L", "AX1R", "AX2L", "AX2R", "AX3L", "AX3R" };
+	set_reg(4, pick(b3 & 0x40, "MACC1", "MACC2"));
+	set_reg(5, REGS[(opcode2 - 0x18) * 2 + ((b3 & 0x80) ? 1 : 0)]);
+}
+
+void Decoder::ana2_21() {
+	switch (b3 >> 6) {
+	case 0: set_secondary("GDADVANCE"); break;
+	case 1: set_secondary("BRDE"); break; //Background XMEM read
+	case 2:
+		set_imm(4, 0);
+		set_reg(5, "GOFF");
+		break;
+	case 3: set_secondary("REFRESH"); break; //Memory refresh
+	}
+}
+
+void Decoder::ana2_CR() {
+	static const char* REGS[] = { "CR0", "CR1", "CR2", "CR3" };
+	int cr_pos = (opcode2 == 0x22) ? 5 : 4; //0x22 writes CRx
+	int cmem_pos = (opcode2 == 0x22) ? 4 : 5;
+	set_reg(cr_pos, REGS[b3 >> 6]);
+	ana_cmem_addressing(cmem_pos);
+}
+
+void Decoder::ana2_hir() {
+	if (b3 & 0x80) {
+		ana_cmem_addressing(4);
+	} else {
+		ana_dmem_addressing(4);
+	}
+	set_reg(5, "HIR");
+}
+
+void Decoder::ana2_advance() {
+	if ((b3 >> 6) == 2) {
+		set_secondary("ADVANCE"); //Circular memory advance
+	} else {
+		set_unknown_secondary();
+	}
+}
+
+void Decoder::ana2_mode(const char* reg, int32_t value, bool signed_value) {
+	set_imm(4, value);
+	ops[4].signed_imm = signed_value;
+	set_reg(5, reg);
+}
+
+void Decoder::ana2_2C() {
+	uint8_t arg = b3 >> 6;
+	if (arg <= 1) {
+		ana2_mode("CR2.FREE", arg & 1, false);
+	} else {
+		ana2_mode(arg == 2 ? "CR1.AOV" : "CR1.MOV", 0, false);
+	}
+}
+
+void Decoder::ana2_noise() {
+	if ((b3 >> 6) < 2) {
+		ana_dmem_addressing(4);
+		ops[4].secondary = "NOISE";
+	} else {
+		set_unknown_secondary();
+	}
+}
+
+std::string Decoder::format(const operand_t& op) {
+	char temp[32];
+	std::string text;
+	switch (op.type) {
+	case OperandType::Reg:
+		if (op.shift) {
+			text = std::string(op.reg) + " " + op.shift + " 1";
+			break;
+		}
+		if (op.negate) {
+			text += "-";
+		}
+		if (op.pointer) {
+			text += "*";
+		}
+		text += op.reg;
+		if (op.post_increment) {
+			text += "+";
+			if (op.increment_reg) {
+				text += op.increment_reg;
+			}
+		}
+		break;
+	case OperandType::Imm:
+		if (op.signed_imm && op.value < 0) {
+			snprintf(temp, sizeof(temp), "#-0x%X", -op.value);
+		} else {
+			snprintf(temp, sizeof(temp), "#0x%X", (uint32_t)op.value);
+		}
+		text = temp;
+		break;
+	case OperandType::Near:
+		snprintf(temp, sizeof(temp), "0x%03X", op.value);
+		text = temp;
+		break;
+	case OperandType::Mem:
+		snprintf(temp, sizeof(temp), "%s%s(0x%X)", op.negate ? "-" : "", op.memory, op.value);
+		text = temp;
+		break;
+	case OperandType::Void:
+		break;
+	}
+	return text;
+}
+
+disasm_t Decoder::result() {
+	disasm_t result;
+	result.mnemonic = mnemonic;
+	for (int i = 0; i < 4 && ops[i].type != OperandType::Void; i++) {
+		if (i) {
+			result.operands += ", ";
+		}
+		result.operands += format(ops[i]);
+	}
+	if (ops[4].type != OperandType::Void) {
+		result.secondary = ops[4].secondary ? ops[4].secondary : "MOV";
+		std::string operand = format(ops[4]);
+		if (!operand.empty()) {
+			result.secondary += " " + operand;
+		}
+		if (ops[5].type != OperandType::Void) {
+			result.secondary += ", " + format(ops[5]);
+		}
+	}
+	return result;
+}
+
+std::string disasm_t::text() const {
+	std::string text = mnemonic;
+	if (!operands.empty()) {
+		text += " " + operands;
+	}
+	if (!secondary.empty()) {
+		//Secondary instructions start in their own column, like the IDA listing
+		text.resize(std::max<size_t>(text.size() + 1, 40), ' ');
+		text += secondary;
+	}
+	return text;
+}
+
+disasm_t TMS57070::disassemble(uint32_t word, uint16_t pc) {
+	return Decoder(word, pc).result();
+}
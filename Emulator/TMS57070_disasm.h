@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace TMS57070 {
+
+	//A decoded instruction word, using the mnemonics and operand syntax of TMS57070_disasm.py
+	struct disasm_t {
+		const char* mnemonic; //Primary instruction, e.g. "MAC(9)". "UNKN" if it could not be decoded
+		std::string operands; //Primary operands, e.g. "SS, CMEM(0x12), *DA1+, MACC1"
+		std::string secondary; //Parallel move or secondary instruction, e.g. "MOV ACC1, DMEM(0x5)". Empty if none
+
+		std::string text() const; //Whole instruction on one line
+	};
+
+	//pc is the address of the word. It is only used for RPTK, whose loop end is the next instruction
+	disasm_t disassemble(uint32_t word, uint16_t pc);
+
+}
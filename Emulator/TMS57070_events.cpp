@@ -0,0 +1,45 @@
+#include "TMS57070_events.h"
+#include <algorithm>
+
+using namespace TMS57070;
+
+//Heap comparator: std::*_heap keep the "largest" element at the front, so invert to get the earliest event there
+static bool later(const event_t& lhs, const event_t& rhs) {
+	if (lhs.cycle != rhs.cycle) {
+		return lhs.cycle > rhs.cycle;
+	}
+	return lhs.seq > rhs.seq;
+}
+
+void EventQueue::push(event_t event) {
+	event.seq = next_seq++;
+	events.push_back(event);
+	std::push_heap(events.begin(), events.end(), later);
+}
+
+void EventQueue::pop() {
+	std::pop_heap(events.begin(), events.end(), later);
+	events.pop_back();
+}
+
+uint64_t EventQueue::next_cycle() const {
+	if (events.empty()) {
+		return UINT64_MAX;
+	}
+	return events.front().cycle;
+}
+
+void EventQueue::remove(EventType type) {
+	auto new_end = std::remove_if(events.begin(), events.end(), [type](const event_t& event) {
+		return event.type == type;
+	});
+	if (new_end != events.end()) {
+		events.erase(new_end, events.end());
+		std::make_heap(events.begin(), events.end(), later);
+	}
+}
+
+void EventQueue::clear() {
+	events.clear();
+	next_seq = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace TMS57070 {
+
+	enum class EventType : uint8_t {
+		XMEMRead, //Background XMEM read (RDE) completes: XRD is written at the end of cycle - 1
+		XMEMWrite, //Deferred XMEM write (WRE) lands
+		SampleIn, //Audio sample arrives on an ARI input
+		ExtInterrupt, //External interrupt pin
+		HIRInterrupt, //Host interface word arrives
+	};
+	constexpr uint32_t EVENT_TYPE_COUNT = 5;
+
+	struct event_t {
+		uint64_t cycle; //Event is handled before the instruction of this cycle executes: at the end of the previous cycle, or on the next step() if scheduled later
+		uint64_t seq; //Keeps events of the same cycle in the order they were scheduled
+		EventType type;
+		uint8_t arg; //Channel or interrupt number
+		uint32_t addr;
+		int32_t value;
+	};
+
+	//Cycle-ordered queue of pending emulator events (binary min-heap)
+	class EventQueue {
+	public:
+		void push(event_t event);
+		void pop();
+		const event_t& top() const { return events.front(); }
+		bool empty() const { return events.empty(); }
+		uint64_t next_cycle() const; //Cycle of the earliest event, or UINT64_MAX when empty
+		void remove(EventType type); //Cancel all pending events of a type
+		void clear();
+
+		const std::vector<event_t>& pending() const { return events; } //Unordered view, for snapshots
+
+	private:
+		std::vector<event_t> events;
+		uint64_t next_seq = 0;
+	};
+
+}
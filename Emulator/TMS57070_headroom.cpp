@@ -0,0 +1,63 @@
+#include "TMS57070_headroom.h"
+#include <algorithm>
+
+using namespace TMS57070;
+
+HeadroomMeter::HeadroomMeter(AudioPort port) {
+	this->port = port;
+	vectors[0] = (port == AudioPort::ARI1) ? 1 : 2;
+	vectors[1] = (port == AudioPort::ARI1) ? 3 : 4;
+}
+
+void HeadroomMeter::reset() {
+	busy = false;
+	overrun = false;
+	periods.clear();
+}
+
+headroom_stats_t HeadroomMeter::stats() const {
+	headroom_stats_t result{ periods.size(), 0, 0.0, 0, 0, budget, 0 };
+	if (periods.empty()) {
+		return result;
+	}
+
+	std::vector<uint32_t> used(periods.size());
+	uint64_t sum = 0;
+	for (size_t i = 0; i < periods.size(); i++) {
+		used[i] = periods[i] & ~OVERRUN_FLAG;
+		sum += used[i];
+		if (periods[i] & OVERRUN_FLAG) {
+			result.overruns++;
+		}
+	}
+	result.mean = (double)sum / used.size();
+	result.min = *std::min_element(used.begin(), used.end());
+	result.max = *std::max_element(used.begin(), used.end());
+	size_t rank = (used.size() * 99 + 99) / 100 - 1; //Nearest rank
+	std::nth_element(used.begin(), used.begin() + rank, used.end());
+	result.p99 = used[rank];
+	return result;
+}
+
+void HeadroomMeter::print(FILE* out) const {
+	headroom_stats_t result = stats();
+	fprintf(out, "Headroom over %llu sample periods, budget %.1f cycles:\n", (unsigned long long)result.periods, result.budget);
+	if (!result.periods) {
+		return;
+	}
+	double scale = result.budget > 0 ? 100.0 / result.budget : 0.0;
+	fprintf(out, "  min  %6u cycles (%5.1f%%)\n", result.min, result.min * scale);
+	fprintf(out, "  mean %6.0f cycles (%5.1f%%)\n", result.mean, result.mean * scale);
+	fprintf(out, "  p99  %6u cycles (%5.1f%%)\n", result.p99, result.p99 * scale);
+	fprintf(out, "  max  %6u cycles (%5.1f%%)\n", result.max, result.max * scale);
+	fprintf(out, "  overruns: %llu\n", (unsigned long long)result.overruns);
+}
+
+std::vector<float> HeadroomMeter::loads() const {
+	std::vector<float> result(periods.size());
+	for (size_t i = 0; i < periods.size(); i++) {
+		double load = budget > 0 ? (periods[i] & ~OVERRUN_FLAG) / budget : 0.0;
+		result[i] = (float)std::min(load, 1.0);
+	}
+	return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TMS57070_clock.h"
+
+namespace TMS57070 {
+
+	struct headroom_stats_t {
+		uint64_t periods; //Sample periods measured
+		uint32_t min; //Cycles from interrupt entry to RETI or idle loop
+		double mean;
+		uint32_t p99;
+		uint32_t max;
+		double budget; //Cycles per sample period
+		uint64_t overruns; //Periods in which the next sample arrived before the handler finished
+	};
+
+	//Measures how much of each sample period the audio interrupt handler of one port uses: the cycles from
+	//the ARI (or ARI A) interrupt entry to its RETI, or to the idle loop for programs that return to one.
+	//A period is an overrun if the port's next sample arrived while the handler still ran (CR2.FREE == 0).
+	//Attach with Emulator::set_headroom_meter(), which also sets the budget from the clock configuration
+	class HeadroomMeter {
+	public:
+		HeadroomMeter(AudioPort port = AudioPort::ARI1);
+		AudioPort audio_port() const { return port; }
+
+		void set_budget(double cycles) { budget = cycles; }
+		void reset(); //Forget all periods
+
+		//Emulator events
+		void interrupt(uint64_t cycle, uint16_t vector) {
+			if (vector == vectors[0] || vector == vectors[1]) {
+				busy = true;
+				entry_cycle = cycle;
+			}
+		}
+		void handler_done(uint64_t cycle) { //RETI or idle loop
+			if (busy) {
+				busy = false;
+				uint32_t used = (uint32_t)(cycle - entry_cycle);
+				periods.push_back(used | (overrun ? OVERRUN_FLAG : 0));
+				overrun = false;
+			}
+		}
+		void sample_arrived(AudioPort sample_port) { //While CR2.FREE == 0
+			if (busy && sample_port == port) {
+				overrun = true;
+			}
+		}
+
+		headroom_stats_t stats() const;
+		void print(FILE* out) const;
+		std::vector<float> loads() const; //Per period: cycles used / budget, clamped to 1. One value per sample, for a control-rate WAV
+		bool overran(uint64_t period) const { return (periods[period] & OVERRUN_FLAG) != 0; }
+
+	private:
+		static constexpr uint32_t OVERRUN_FLAG = 0x80000000;
+
+		AudioPort port;
+		uint16_t vectors[2]; //ARIx and ARIxA, see int_vector_decode()
+		double budget = (double)DEFAULT_DSP_CLOCK_HZ / DEFAULT_SAMPLE_RATE;
+		bool busy = false;
+		bool overrun = false;
+		uint64_t entry_cycle = 0;
+		std::vector<uint32_t> periods; //Cycles used, OVERRUN_FLAG set for overruns
+	};
+
+}
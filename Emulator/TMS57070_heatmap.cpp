@@ -0,0 +1,155 @@
+#include "TMS57070_heatmap.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const char* const MEMORY_NAMES[3] = { "CMEM", "DMEM", "XMEM" };
+static const uint32_t MEMORY_WORDS[3] = { 512, 512, HEATMAP_XMEM_WORDS };
+
+AccessHeatmap::AccessHeatmap() {
+	for (uint32_t index = 0; index < 3; index++) {
+		memories[index].accesses.resize(MEMORY_WORDS[index]);
+		memories[index].writes.resize(MEMORY_WORDS[index]);
+		memories[index].last_period.resize(MEMORY_WORDS[index]);
+	}
+	reset();
+}
+
+void AccessHeatmap::reset() {
+	for (memory_t& memory : memories) {
+		std::fill(memory.accesses.begin(), memory.accesses.end(), 0);
+		std::fill(memory.writes.begin(), memory.writes.end(), 0);
+		std::fill(memory.last_period.begin(), memory.last_period.end(), 0);
+		memset(memory.strides, 0, sizeof(memory.strides));
+		memset(&memory.circular, 0, sizeof(memory.circular));
+		memory.period_words = 0;
+		memory.period_min = UINT32_MAX;
+		memory.period_max = 0;
+		memory.period_total = 0;
+	}
+	period = 1;
+}
+
+void AccessHeatmap::circular(TraceTarget target, uint32_t start, uint32_t length) {
+	circular_t& circular = memories[memory_index(target)].circular;
+	if (circular.rotations == 0) {
+		circular.first_start = start;
+		circular.min_length = length;
+		circular.max_length = length;
+	}
+	circular.rotations++;
+	circular.last_start = start;
+	circular.min_length = std::min(circular.min_length, length);
+	circular.max_length = std::max(circular.max_length, length);
+}
+
+void AccessHeatmap::sample() {
+	for (memory_t& memory : memories) {
+		memory.period_min = std::min(memory.period_min, memory.period_words);
+		memory.period_max = std::max(memory.period_max, memory.period_words);
+		memory.period_total += memory.period_words;
+		memory.period_words = 0;
+	}
+	period++;
+}
+
+uint32_t AccessHeatmap::working_set(TraceTarget target) const {
+	const memory_t& memory = memories[memory_index(target)];
+	return (uint32_t)(memory.accesses.size() - std::count(memory.accesses.begin(), memory.accesses.end(), 0));
+}
+
+void AccessHeatmap::print(FILE* out) const {
+	fprintf(out, "Memory accesses over %" PRIu64 " sample periods\n", period - 1);
+	for (uint32_t index = 0; index < 3; index++) {
+		print_memory(out, index);
+	}
+}
+
+void AccessHeatmap::print_memory(FILE* out, uint32_t index) const {
+	const memory_t& memory = memories[index];
+	uint32_t words = MEMORY_WORDS[index];
+
+	uint32_t read_only = 0, write_only = 0, read_write = 0, highest = 0;
+	for (uint32_t addr = 0; addr < words; addr++) {
+		if (!memory.accesses[addr]) {
+			continue;
+		}
+		uint64_t reads = memory.accesses[addr] - memory.writes[addr];
+		if (!memory.writes[addr]) {
+			read_only++;
+		} else if (!reads) {
+			write_only++;
+		} else {
+			read_write++;
+		}
+		highest = addr;
+	}
+	uint32_t accessed = read_only + write_only + read_write;
+	fprintf(out, "\n%s: %u of %u words accessed (%u read only, %u write only, %u both)", MEMORY_NAMES[index], accessed, words, read_only, write_only, read_write);
+	if (!accessed) {
+		fprintf(out, "\n");
+		return;
+	}
+	fprintf(out, ", highest 0x%X\n", highest);
+	if (period > 1) {
+		fprintf(out, "  Per sample period: min %u, mean %.1f, max %u words\n", memory.period_min, (double)memory.period_total / (period - 1), memory.period_max);
+	}
+
+	//Hottest words
+	std::vector<uint32_t> hottest;
+	for (uint32_t addr = 0; addr <= highest; addr++) {
+		if (memory.accesses[addr]) {
+			hottest.push_back(addr);
+		}
+	}
+	size_t shown = std::min(hottest.size(), (size_t)8);
+	std::partial_sort(hottest.begin(), hottest.begin() + shown, hottest.end(), [&](uint32_t a, uint32_t b) { return memory.accesses[a] > memory.accesses[b]; });
+	fprintf(out, "  Hottest:");
+	for (size_t rank = 0; rank < shown; rank++) {
+		uint32_t addr = hottest[rank];
+		fprintf(out, " %X (%" PRIu64 "r/%" PRIu64 "w)", addr, memory.accesses[addr] - memory.writes[addr], memory.writes[addr]);
+	}
+	fprintf(out, "\n");
+
+	//Instructions that step through memory at a steady stride, such as repeated MACs over a table (+1)
+	//or direct addresses moved by a circular offset every sample (-1)
+	uint32_t fixed = 0;
+	for (uint32_t pc = 0; pc < 512; pc++) {
+		const stride_t& stride = memory.strides[pc];
+		if (stride.accesses < 16 || stride.repeats * 4 < stride.accesses * 3) {
+			continue;
+		}
+		if (stride.stride == 0) {
+			fixed++;
+		} else {
+			fprintf(out, "  PC %03X: stride %+d in %.0f%% of %" PRIu64 " accesses\n", pc, stride.stride, 100.0 * stride.repeats / (stride.accesses - 1), stride.accesses);
+		}
+	}
+	if (fixed) {
+		fprintf(out, "  %u instructions access a fixed word\n", fixed);
+	}
+
+	const circular_t& circular = memory.circular;
+	if (circular.rotations) {
+		fprintf(out, "  Circular: %" PRIu64 " rotations, start 0x%X to 0x%X", circular.rotations, circular.first_start, circular.last_start);
+		if (index != memory_index(TraceTarget::XMEM)) {
+			fprintf(out, ", %s 0x%X to 0x%X", (index == 0) ? "CCIRC" : "DCIRC", circular.min_length, circular.max_length);
+		}
+		fprintf(out, "\n");
+	}
+}
+
+bool AccessHeatmap::write_heatmap(FILE* out) const {
+	bool ok = fprintf(out, "memory,address,reads,writes\n") > 0;
+	for (uint32_t index = 0; index < 3; index++) {
+		const memory_t& memory = memories[index];
+		for (uint32_t addr = 0; addr < MEMORY_WORDS[index] && ok; addr++) {
+			if (memory.accesses[addr]) {
+				ok = fprintf(out, "%s,%u,%" PRIu64 ",%" PRIu64 "\n", MEMORY_NAMES[index], addr, memory.accesses[addr] - memory.writes[addr], memory.writes[addr]) > 0;
+			}
+		}
+	}
+	return ok;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	constexpr uint32_t HEATMAP_XMEM_WORDS = 0x10000; //Largest XMEM xmemAddressing() can address
+
+	//Counts accesses per word of CMEM, DMEM and XMEM, at the effective addresses after COFF/DOFF/XOFF and
+	//the memory size masks. Every effective address computation is one access; writes are counted where they
+	//land, so reads are accesses minus writes. Also finds the words touched per sample period, the stride of each
+	//instruction's accesses from one execution to the next, and the circular buffers rotated by 0x27.
+	//Attach with Emulator::set_heatmap()
+	class AccessHeatmap {
+	public:
+		AccessHeatmap();
+		void reset(); //Forget all counts
+
+		//Emulator events
+		void fetch(uint16_t pc) { this->pc = pc; }
+		void access(TraceTarget target, uint32_t addr) {
+			memory_t& memory = memories[memory_index(target)];
+			memory.accesses[addr]++;
+			if (memory.last_period[addr] != period) {
+				memory.last_period[addr] = period;
+				memory.period_words++;
+			}
+			stride_t& stride = memory.strides[pc];
+			int32_t delta = (int32_t)addr - (int32_t)stride.last_addr;
+			if (stride.accesses && delta == stride.stride) {
+				stride.repeats++;
+			}
+			stride.stride = delta;
+			stride.last_addr = addr;
+			stride.accesses++;
+		}
+		void write(TraceTarget target, uint32_t addr) {
+			memories[memory_index(target)].writes[addr]++;
+		}
+		void circular(TraceTarget target, uint32_t start, uint32_t length); //0x27 moved the offset of a memory. start: effective address of word 0 (masked XOFF for XMEM), length: CCIRC/DCIRC, 0 for XMEM
+		void sample(); //End of a sample period
+
+		uint64_t reads(TraceTarget target, uint32_t addr) const {
+			const memory_t& memory = memories[memory_index(target)];
+			return memory.accesses[addr] - memory.writes[addr];
+		}
+		uint64_t writes(TraceTarget target, uint32_t addr) const { return memories[memory_index(target)].writes[addr]; }
+		uint32_t working_set(TraceTarget target) const; //Words accessed at least once
+
+		void print(FILE* out) const; //Working sets, per-period working sets, strides and circular buffers
+		bool write_heatmap(FILE* out) const; //CSV of memory,address,reads,writes for every accessed word
+
+	private:
+		struct stride_t {
+			uint32_t last_addr;
+			int32_t stride; //Between the last two accesses
+			uint64_t accesses;
+			uint64_t repeats; //Accesses at the same stride as the access before
+		};
+		struct circular_t {
+			uint64_t rotations; //0x27 executions
+			uint32_t first_start; //Effective address of word 0 after the first rotation
+			uint32_t last_start;
+			uint32_t min_length;
+			uint32_t max_length;
+		};
+		struct memory_t {
+			std::vector<uint64_t> accesses;
+			std::vector<uint64_t> writes;
+			std::vector<uint64_t> last_period; //Last period + 1 in which the word was accessed
+			stride_t strides[512]; //Per PC
+			circular_t circular;
+			uint32_t period_words; //Words accessed in the current period
+			uint32_t period_min;
+			uint32_t period_max;
+			uint64_t period_total;
+		};
+
+		static uint32_t memory_index(TraceTarget target) { return (uint32_t)target - (uint32_t)TraceTarget::CMEM; }
+		void print_memory(FILE* out, uint32_t index) const;
+
+		memory_t memories[3]; //CMEM, DMEM, XMEM
+		uint64_t period = 1; //Periods + 1, so that 0 in last_period means never
+		uint16_t pc = 0;
+	};
+
+}
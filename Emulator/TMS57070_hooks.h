@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	class Emulator;
+	enum class Channel;
+
+	//Instrumentation points of the execution core, for tools that live outside the emulator. Derive from this,
+	//override the points needed and attach it with Emulator::set_hooks(). Like the built-in observers, the hooks
+	//are called from the observed instantiations of the core only (see core_config_t), so they cost nothing while
+	//none is attached
+	class CoreHooks {
+	public:
+		virtual ~CoreHooks() = default;
+
+		virtual void fetch(uint64_t /*cycle*/, uint16_t /*pc*/, uint32_t /*insn*/) {}
+		virtual void access(uint64_t /*cycle*/, TraceTarget /*target*/, uint32_t /*addr*/) {} //Effective CMEM/DMEM/XMEM address computed. A read unless write() follows for it
+		virtual void write(uint64_t /*cycle*/, TraceTarget /*target*/, uint32_t /*addr*/, int32_t /*value*/) {}
+		virtual void register_write(uint64_t /*cycle*/, TraceReg /*reg*/, uint32_t /*value*/) {} //Only with register_writes set. Values as traced
+		virtual void instruction_end(uint64_t /*cycle*/, uint16_t /*pc*/) {}
+		virtual void interrupt_enter(uint64_t /*cycle*/, uint16_t /*vector*/, uint16_t /*return_pc*/) {}
+		virtual void interrupt_exit(uint64_t /*cycle*/, uint16_t /*return_pc*/) {} //RETI
+		virtual void repeat_start(uint64_t /*cycle*/, uint16_t /*start_pc*/, uint16_t /*end_pc*/, uint32_t /*count*/) {} //RPTK or RPTB. count: repeats after the first pass
+		virtual void repeat_end(uint64_t /*cycle*/, uint16_t /*pc*/) {} //The loop branched back for the last time: its final pass starts
+		virtual void sample_in(uint64_t /*cycle*/, Channel /*channel*/, int32_t /*value*/) {}
+		virtual void sample_out(uint64_t /*cycle*/, Channel /*channel*/, int32_t /*value*/) {}
+
+		bool register_writes = false; //Compare the registers after every instruction to call register_write(). Set before attaching
+	};
+
+	//Hook policy of the unobserved cores: every hook point compiles to nothing.
+	//The observed cores use ObserverHooks (TMS57070.h), which calls the built-in observers and the attached CoreHooks.
+	//Interrupt entry and audio samples are not policy points: they are rare, and call CoreHooks after a runtime check
+	struct NoHooks {
+		static void fetch(Emulator& /*emulator*/, uint16_t /*pc*/, uint32_t /*insn*/) {}
+		static void access(Emulator& /*emulator*/, TraceTarget /*target*/, uint32_t /*addr*/) {}
+		static void write(Emulator& /*emulator*/, TraceTarget /*target*/, uint32_t /*addr*/, int32_t /*value*/) {}
+		static void instruction_end(Emulator& /*emulator*/, uint16_t /*pc*/) {}
+		static void interrupt_exit(Emulator& /*emulator*/, uint16_t /*return_pc*/) {}
+		static void repeat_start(Emulator& /*emulator*/, uint16_t /*start_pc*/, uint16_t /*end_pc*/, uint32_t /*count*/) {}
+		static void repeat_end(Emulator& /*emulator*/, uint16_t /*pc*/) {}
+		static void branch(Emulator& /*emulator*/, uint16_t /*target*/) {}
+		static void circular(Emulator& /*emulator*/, TraceTarget /*target*/, uint32_t /*start*/, uint32_t /*length*/) {}
+	};
+	struct ObserverHooks;
+
+}
@@ -0,0 +1,47 @@
+#include "TMS57070_memory.h"
+#include <cassert>
+
+using namespace TMS57070;
+
+PagedMemory::PagedMemory(uint32_t words) {
+	this->words = words;
+	table = std::make_shared<table_t>();
+	table->pages.resize((words + PAGE_WORDS - 1) >> PAGE_BITS);
+}
+
+void PagedMemory::write(uint32_t addr, int32_t value) {
+	assert(addr < words);
+
+	//Unshare the page table, then the page itself
+	if (table.use_count() > 1) {
+		table = std::make_shared<table_t>(*table);
+	}
+	std::shared_ptr<page_t>& page = table->pages[addr >> PAGE_BITS];
+	if (!page) {
+		page = std::make_shared<page_t>(); //Value-initialized, so all zero
+		table->used.push_back(addr >> PAGE_BITS);
+	} else if (page.use_count() > 1) {
+		page = std::make_shared<page_t>(*page);
+	}
+
+	page->words[addr & (PAGE_WORDS - 1)] = (int32_t)((uint32_t)value << 8) >> 8; //Truncate to 24 bits, keep sign
+}
+
+void PagedMemory::clear() {
+	if (table.use_count() > 1) {
+		//Shared with a fork: leave its pages alone
+		size_t page_count = table->pages.size();
+		table = std::make_shared<table_t>();
+		table->pages.resize(page_count);
+		return;
+	}
+	for (uint32_t index : table->used) {
+		table->pages[index].reset();
+	}
+	table->used.clear();
+}
+
+const int32_t* PagedMemory::page(uint32_t index) const {
+	const page_t* page = table->pages[index].get();
+	return page ? page->words : nullptr;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace TMS57070 {
+
+	//Sparse word-addressed memory of 24-bit words, shared copy-on-write at page granularity.
+	//Copying a PagedMemory is constant time: both copies share all pages until one of them writes.
+	//Pages that were never written read as zero and take no space.
+	//Copies may be used from different threads, but a PagedMemory must not be copied while another thread writes to it
+	class PagedMemory {
+	public:
+		static constexpr uint32_t PAGE_BITS = 12;
+		static constexpr uint32_t PAGE_WORDS = 1 << PAGE_BITS;
+
+		PagedMemory(uint32_t words);
+
+		int32_t read(uint32_t addr) const {
+			const page_t* page = table->pages[addr >> PAGE_BITS].get();
+			return page ? page->words[addr & (PAGE_WORDS - 1)] : 0;
+		}
+		void write(uint32_t addr, int32_t value);
+		void clear(); //Release all pages, so that every word reads as zero. Costs one step per page in use, not per page of the memory
+
+		uint32_t size() const { return words; }
+		uint32_t page_count() const { return (uint32_t)table->pages.size(); }
+		const int32_t* page(uint32_t index) const; //Null if the page was never written
+
+	private:
+		struct page_t {
+			int32_t words[PAGE_WORDS]; //Sign-extended 24-bit values
+		};
+		struct table_t {
+			std::vector<std::shared_ptr<page_t>> pages;
+			std::vector<uint32_t> used; //Indices of the pages that are not null
+		};
+
+		std::shared_ptr<table_t> table;
+		uint32_t words;
+	};
+
+}
@@ -0,0 +1,18 @@
+#include "TMS57070_overflow.h"
+
+using namespace TMS57070;
+
+void OverflowCounters::print(FILE* out) const {
+	static const char* CHANNEL_NAMES[OUTPUT_CHANNELS] = { "AX1L", "AX1R", "AX2L", "AX2R", "AX3L", "AX3R" };
+	fprintf(out, "ACC saturations:    %llu\n", (unsigned long long)totals.acc_saturations);
+	fprintf(out, "ACC wraps:          %llu\n", (unsigned long long)totals.acc_wraps);
+	fprintf(out, "AOV latched:        %llu\n", (unsigned long long)totals.aov_latches);
+	fprintf(out, "MAC limiter clamps: %llu\n", (unsigned long long)totals.mac_clamps);
+	for (uint32_t channel = 0; channel < OUTPUT_CHANNELS; channel++) {
+		if (totals.outputs[channel]) {
+			fprintf(out, "%s clipped:       %llu of %llu samples (%.3f%%)\n", CHANNEL_NAMES[channel],
+				(unsigned long long)totals.output_clips[channel], (unsigned long long)totals.outputs[channel],
+				100.0 * totals.output_clips[channel] / totals.outputs[channel]);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+namespace TMS57070 {
+
+	//Bits of OverflowCounters::take_events()
+	enum OverflowEvent : uint32_t {
+		OVERFLOW_ACC_SATURATED = 1 << 0,
+		OVERFLOW_ACC_WRAPPED = 1 << 1,
+		OVERFLOW_AOV_LATCHED = 1 << 2,
+		OVERFLOW_MAC_CLAMPED = 1 << 3,
+		OVERFLOW_OUTPUT_CLIPPED = 1 << 4, //Any AX channel
+	};
+
+	constexpr uint32_t OUTPUT_CHANNELS = 6; //AX1L to AX3R, indexed from Channel::out_1L
+
+	struct overflow_counts_t {
+		uint64_t acc_saturations; //processACCValue() clamped a result (CR1.AOVM set)
+		uint64_t acc_wraps; //A result overflowed and was truncated (CR1.AOVM clear)
+		uint64_t aov_latches; //CR1.AOV went from 0 to 1
+		uint64_t mac_clamps; //The MAC overflow limiter (CR1.MOVM) clamped a value an instruction used
+		uint64_t output_clips[OUTPUT_CHANNELS]; //Output samples at full scale
+		uint64_t outputs[OUTPUT_CHANNELS]; //Output samples
+	};
+
+	//Counts how often the program saturates, overflows and clips. Plain counters the emulator increments,
+	//so the host can read counts() at any time, e.g. between sample periods of a block render.
+	//Attach with Emulator::set_overflow_counters()
+	class OverflowCounters {
+	public:
+		void reset() {
+			totals = overflow_counts_t();
+			events = 0;
+		}
+
+		//Emulator events
+		void acc_saturated() {
+			totals.acc_saturations++;
+			events |= OVERFLOW_ACC_SATURATED;
+		}
+		void acc_wrapped() {
+			totals.acc_wraps++;
+			events |= OVERFLOW_ACC_WRAPPED;
+		}
+		void aov_latched() {
+			totals.aov_latches++;
+			events |= OVERFLOW_AOV_LATCHED;
+		}
+		void mac_clamped() {
+			totals.mac_clamps++;
+			events |= OVERFLOW_MAC_CLAMPED;
+		}
+		void output(uint32_t channel, int32_t value) { //channel counts from Channel::out_1L
+			totals.outputs[channel]++;
+			if (value >= 0x7FFFFF || value <= -0x800000) {
+				totals.output_clips[channel]++;
+				events |= OVERFLOW_OUTPUT_CLIPPED;
+			}
+		}
+
+		const overflow_counts_t& counts() const { return totals; }
+		uint32_t take_events() { //OverflowEvent bits seen since the previous call, e.g. once per sample for an event channel
+			uint32_t seen = events;
+			events = 0;
+			return seen;
+		}
+		void print(FILE* out) const;
+
+	private:
+		overflow_counts_t totals = {};
+		uint32_t events = 0;
+	};
+
+}
@@ -0,0 +1,39 @@
+#include "TMS57070_pool.h"
+
+using namespace TMS57070;
+
+EmulatorPool::EmulatorPool(size_t preallocate) {
+	for (size_t i = 0; i < preallocate; i++) {
+		std::unique_ptr<Emulator> emulator = std::make_unique<Emulator>();
+		emulator->reset();
+		emulators.push_back(std::move(emulator));
+	}
+}
+
+std::unique_ptr<Emulator> EmulatorPool::acquire() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!emulators.empty()) {
+			std::unique_ptr<Emulator> emulator = std::move(emulators.back());
+			emulators.pop_back();
+			return emulator;
+		}
+	}
+	std::unique_ptr<Emulator> emulator = std::make_unique<Emulator>();
+	emulator->reset();
+	return emulator;
+}
+
+void EmulatorPool::release(std::unique_ptr<Emulator> emulator) {
+	if (!emulator) {
+		return;
+	}
+	emulator->clear(); //Outside the lock: other jobs keep going
+	std::lock_guard<std::mutex> lock(mutex);
+	emulators.push_back(std::move(emulator));
+}
+
+size_t EmulatorPool::idle() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return emulators.size();
+}
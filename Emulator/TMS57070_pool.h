@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TMS57070.h"
+
+namespace TMS57070 {
+
+	//Reusable emulators for batch jobs, instead of constructing one per job.
+	//acquire() hands out an emulator in the state of a newly constructed one after reset(), whatever the previous job
+	//left in it, so results do not depend on which instance a job gets. Emulators are cleared when they are released
+	//(see Emulator::clear()), which costs little for short jobs: only the XMEM pages they wrote are released.
+	//Thread-safe: jobs on different threads may acquire and release concurrently
+	class EmulatorPool {
+	public:
+		EmulatorPool(size_t preallocate = 0);
+
+		std::unique_ptr<Emulator> acquire(); //A pooled emulator, or a new one if none is idle
+		void release(std::unique_ptr<Emulator> emulator); //Clear an emulator and keep it for the next acquire(). It need not come from this pool
+		size_t idle(); //Emulators waiting to be acquired
+
+	private:
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Emulator>> emulators;
+	};
+
+}
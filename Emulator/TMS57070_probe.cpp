@@ -0,0 +1,102 @@
+#include "TMS57070_probe.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint8_t PROBE_MAGIC[4] = { 'T', '5', '7', 'P' };
+
+void ProbeSet::add(TraceTarget target, uint32_t addr) {
+	probes.push_back(probe_t{ target, addr });
+	registers = registers || target == TraceTarget::Register;
+	clear(); //Frames have a fixed layout
+}
+
+bool ProbeSet::parse(const char* spec) {
+	static const struct {
+		const char* name;
+		TraceTarget target;
+		uint32_t words;
+	} MEMORIES[] = {
+		{ "CMEM", TraceTarget::CMEM, 512 },
+		{ "DMEM", TraceTarget::DMEM, 512 },
+		{ "XMEM", TraceTarget::XMEM, 0xFFFFFF },
+	};
+
+	while (*spec) {
+		const char* end = strchr(spec, ',');
+		size_t length = end ? (size_t)(end - spec) : strlen(spec);
+		char item[32];
+		if (length == 0 || length >= sizeof(item)) {
+			return false;
+		}
+		memcpy(item, spec, length);
+		item[length] = '\0';
+
+		bool found = false;
+		char* colon = strchr(item, ':');
+		if (colon) {
+			*colon = '\0';
+			char* digits_end;
+			uint32_t addr = strtoul(colon + 1, &digits_end, 16);
+			for (const auto& memory : MEMORIES) {
+				if (strcmp(item, memory.name) == 0 && *digits_end == '\0' && digits_end != colon + 1 && addr < memory.words) {
+					add(memory.target, addr);
+					found = true;
+				}
+			}
+		} else {
+			TraceReg reg;
+			if (trace_reg_from_name(item, &reg)) {
+				add(TraceTarget::Register, (uint32_t)reg);
+				found = true;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+		spec += length + (end ? 1 : 0);
+	}
+	return true;
+}
+
+void ProbeSet::reserve(size_t frames) {
+	values.resize(std::max(values.size(), frames * probes.size()));
+}
+
+void ProbeSet::clear() {
+	used_frames = 0;
+}
+
+std::vector<float> ProbeSet::channel(size_t index) const {
+	std::vector<float> samples(used_frames);
+	for (size_t frame = 0; frame < used_frames; frame++) {
+		samples[frame] = (float)value(frame, index) / 0x7FFFFF;
+	}
+	return samples;
+}
+
+bool ProbeSet::write(const char* path) const {
+	FILE* out = fopen(path, "wb");
+	if (!out) {
+		return false;
+	}
+	uint8_t header[8];
+	memcpy(header, PROBE_MAGIC, 4);
+	header[4] = PROBE_VERSION & 0xFF;
+	header[5] = PROBE_VERSION >> 8;
+	header[6] = probes.size() & 0xFF;
+	header[7] = (uint8_t)(probes.size() >> 8);
+	bool ok = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+	for (const probe_t& probe : probes) {
+		uint8_t descriptor[8] = { (uint8_t)probe.target, 0, 0, 0,
+			(uint8_t)probe.addr, (uint8_t)(probe.addr >> 8), (uint8_t)(probe.addr >> 16), (uint8_t)(probe.addr >> 24) };
+		ok = ok && fwrite(descriptor, 1, sizeof(descriptor), out) == sizeof(descriptor);
+	}
+	//Frames are stored in host byte order, as trace files are
+	size_t count = used_frames * probes.size();
+	ok = ok && fwrite(values.data(), sizeof(int32_t), count, out) == count;
+	return fclose(out) == 0 && ok;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "TMS57070_trace.h"
+
+namespace TMS57070 {
+
+	//Probe file layout (little-endian):
+	//  "T57P", uint16 version, uint16 probe count
+	//  per probe: uint8 TraceTarget, uint8 reserved, uint16 reserved, uint32 address (TraceReg for registers)
+	//  frames: one int32 per probe, sign-extended 24-bit values
+	constexpr uint16_t PROBE_VERSION = 1;
+
+	struct probe_t {
+		TraceTarget target; //CMEM, DMEM, XMEM or Register
+		uint32_t addr; //Word address, or TraceReg
+	};
+
+	//Memory words and registers captured at the end of every run_sample_period(), like scope taps on
+	//internal signals (LFOs, envelopes, delay taps). Values go into one preallocated buffer, a frame of
+	//one value per probe each sample. Attach with Emulator::set_probes()
+	class ProbeSet {
+	public:
+		void add(TraceTarget target, uint32_t addr);
+		bool parse(const char* spec); //Comma-separated probes: "CMEM:0C,DMEM:1F0,XMEM:1000,ACC1,MAC2" (hex addresses, TraceReg names)
+		void reserve(size_t frames); //Preallocate, so that capturing never allocates
+		void clear(); //Drop captured frames, keep the probes
+
+		size_t count() const { return probes.size(); }
+		const probe_t& probe(size_t index) const { return probes[index]; }
+		bool has_registers() const { return registers; }
+		size_t frames() const { return used_frames; }
+		int32_t value(size_t frame, size_t index) const { return values[frame * probes.size() + index]; }
+
+		int32_t* next_frame() { //Storage for one frame of count() values
+			size_t end = (used_frames + 1) * probes.size();
+			if (end > values.size()) {
+				values.resize(std::max(values.size() * 2, end));
+			}
+			return &values[used_frames++ * probes.size()];
+		}
+
+		std::vector<float> channel(size_t index) const; //One probe as samples of full scale 1.0, for a WAV channel
+		bool write(const char* path) const; //Probe file
+
+	private:
+		std::vector<probe_t> probes;
+		std::vector<int32_t> values;
+		size_t used_frames = 0;
+		bool registers = false;
+	};
+
+}
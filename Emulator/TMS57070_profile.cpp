@@ -0,0 +1,126 @@
+#include "TMS57070_profile.h"
+#include "TMS57070_disasm.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const char* VECTOR_NAMES[Profiler::VECTORS] = {
+	"RESET", "ARI1", "ARI2", "ARI1A", "ARI2A", "HIR", "INT1", "INT2", "INT3",
+};
+
+//Unconditional direct jump to its own address: the program is waiting for an interrupt
+static bool is_idle_loop(uint32_t word, uint16_t pc) {
+	uint8_t opcode = word >> 24;
+	return opcode >= 0xF0 && opcode < 0xF8 && ((word >> 20) & 0x7C) == 0 && (word & 0x1FF) == pc;
+}
+
+Profiler::Profiler() {
+	reset();
+}
+
+void Profiler::reset() {
+	contexts.clear();
+	contexts.push_back(context_t{ {}, 0, std::vector<uint64_t>(PMEM_WORDS) });
+	context = 0;
+	depth = 0;
+	memset(frames, 0, sizeof(frames));
+	memset(repeat, 0, sizeof(repeat));
+	memset(interrupt_entries, 0, sizeof(interrupt_entries));
+}
+
+//SP changed: pc is the first instruction at the new depth. Contexts are few, so a linear search is fine
+void Profiler::enter_context(uint16_t pc, uint8_t sp) {
+	sp = std::min<uint8_t>(sp, MAX_DEPTH);
+	for (uint8_t i = depth; i < sp; i++) {
+		frames[i] = pc;
+	}
+	depth = sp;
+
+	for (uint32_t i = 0; i < contexts.size(); i++) {
+		if (contexts[i].depth == depth && memcmp(contexts[i].frames, frames, depth * sizeof(uint16_t)) == 0) {
+			context = i;
+			return;
+		}
+	}
+	context_t entered{ {}, depth, std::vector<uint64_t>(PMEM_WORDS) };
+	memcpy(entered.frames, frames, sizeof(frames));
+	contexts.push_back(entered);
+	context = (uint32_t)contexts.size() - 1;
+}
+
+uint64_t Profiler::executions(uint16_t pc) const {
+	uint64_t count = 0;
+	for (const context_t& entry : contexts) {
+		count += entry.cycles[pc];
+	}
+	return count;
+}
+
+uint64_t Profiler::total_cycles() const {
+	uint64_t count = 0;
+	for (uint16_t pc = 0; pc < PMEM_WORDS; pc++) {
+		count += executions(pc);
+	}
+	return count;
+}
+
+uint64_t Profiler::idle_cycles(const uint32_t pmem[PMEM_WORDS]) const {
+	uint64_t count = 0;
+	for (uint16_t pc = 0; pc < PMEM_WORDS; pc++) {
+		if (is_idle_loop(pmem[pc], pc)) {
+			count += executions(pc);
+		}
+	}
+	return count;
+}
+
+const char* Profiler::vector_name(uint16_t vector) {
+	return vector < VECTORS ? VECTOR_NAMES[vector] : "?";
+}
+
+void Profiler::print_listing(const uint32_t pmem[PMEM_WORDS], FILE* out) const {
+	uint64_t total = total_cycles();
+	uint64_t idle = idle_cycles(pmem);
+	double scale = total ? 100.0 / total : 0.0;
+	fprintf(out, "Cycles: %llu, idle: %llu (%.2f%%)\n", (unsigned long long)total, (unsigned long long)idle, idle * scale);
+	for (uint16_t vector = 0; vector < VECTORS; vector++) {
+		if (interrupt_entries[vector]) {
+			fprintf(out, "Interrupt %-5s entered %llu times\n", vector_name(vector), (unsigned long long)interrupt_entries[vector]);
+		}
+	}
+
+	fprintf(out, "\n PC  Word      Executions  Cycles%%      Repeat  Instruction\n");
+	for (uint16_t pc = 0; pc < PMEM_WORDS; pc++) {
+		uint64_t count = executions(pc);
+		if (!count && !pmem[pc]) {
+			continue; //Unused PMEM
+		}
+		if (pc < VECTORS && count) {
+			fprintf(out, "%s:\n", vector_name(pc));
+		}
+		disasm_t decoded = disassemble(pmem[pc], pc);
+		fprintf(out, "%03X  %08X  %10llu  %6.2f%%  %10llu  %s%s\n", pc, pmem[pc], (unsigned long long)count, count * scale,
+			(unsigned long long)repeat[pc], decoded.text().c_str(), is_idle_loop(pmem[pc], pc) ? "  ; idle" : "");
+	}
+}
+
+void Profiler::write_folded(const uint32_t pmem[PMEM_WORDS], FILE* out) const {
+	for (const context_t& entry : contexts) {
+		char stack[128] = "main";
+		size_t length = strlen(stack);
+		for (uint8_t i = 0; i < entry.depth; i++) {
+			uint16_t frame = entry.frames[i];
+			if (frame < VECTORS) {
+				length += snprintf(stack + length, sizeof(stack) - length, ";%s", vector_name(frame));
+			} else {
+				length += snprintf(stack + length, sizeof(stack) - length, ";sub_%03X", frame);
+			}
+		}
+		for (uint16_t pc = 0; pc < PMEM_WORDS; pc++) {
+			if (entry.cycles[pc]) {
+				fprintf(out, "%s;%03X_%s %llu\n", stack, pc, disassemble(pmem[pc], pc).mnemonic, (unsigned long long)entry.cycles[pc]);
+			}
+		}
+	}
+}
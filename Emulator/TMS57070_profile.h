@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace TMS57070 {
+
+	//Counts where the cycles of a run go: executions per PMEM address, cycles inside repeat loops,
+	//interrupt entries per vector and cycles in idle loops (jumps to themselves).
+	//Cycles are also kept per call stack, for flame graphs. Frames are found from SP: when it grows, the next
+	//instruction is the entry of a subroutine or an interrupt vector, and when it shrinks the frame is left.
+	//Attach with Emulator::set_profiler()
+	class Profiler {
+	public:
+		static constexpr uint32_t PMEM_WORDS = 512;
+		static constexpr uint32_t VECTORS = 9; //Vector addresses, 0 (reset) to 8
+		static constexpr uint32_t MAX_DEPTH = 4; //Hardware stack size
+
+		Profiler();
+		void reset(); //Forget all counts
+
+		void fetch(uint16_t pc, uint8_t sp, bool repeating) { //Called for every instruction fetched
+			if (sp != depth) {
+				enter_context(pc, sp);
+			}
+			contexts[context].cycles[pc]++;
+			if (repeating) {
+				repeat[pc]++;
+			}
+		}
+		void interrupt(uint16_t vector) { interrupt_entries[vector]++; } //Called when an interrupt is taken
+
+		uint64_t executions(uint16_t pc) const; //Fetches at pc, repeats included
+		uint64_t repeat_cycles(uint16_t pc) const { return repeat[pc]; } //Fetches at pc while RPTC was non-zero
+		uint64_t interrupts(uint16_t vector) const { return interrupt_entries[vector]; }
+		uint64_t total_cycles() const;
+		uint64_t idle_cycles(const uint32_t pmem[PMEM_WORDS]) const;
+
+		void print_listing(const uint32_t pmem[PMEM_WORDS], FILE* out) const; //Disassembly annotated with the counts
+		void write_folded(const uint32_t pmem[PMEM_WORDS], FILE* out) const; //"frame;frame;leaf cycles" lines for flamegraph.pl and similar tools
+
+		static const char* vector_name(uint16_t vector);
+
+	private:
+		struct context_t {
+			uint16_t frames[MAX_DEPTH]; //Entry PCs, outermost first
+			uint8_t depth;
+			std::vector<uint64_t> cycles; //Per PC
+		};
+
+		void enter_context(uint16_t pc, uint8_t sp);
+
+		std::vector<context_t> contexts; //contexts[0] is the top level
+		uint32_t context = 0;
+		uint8_t depth = 0;
+		uint16_t frames[MAX_DEPTH] = {};
+		uint64_t repeat[PMEM_WORDS];
+		uint64_t interrupt_entries[VECTORS];
+	};
+
+}
@@ -0,0 +1,250 @@
+#include "TMS57070_replay.h"
+#include "TMS57070.h"
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint8_t INPUT_LOG_MAGIC[4] = { 'T', '5', '7', 'L' };
+constexpr size_t INPUT_LOG_HEADER_SIZE = 16;
+
+InputRecorder::~InputRecorder() {
+	if (file) {
+		flush();
+		fclose(file);
+	}
+}
+
+bool InputRecorder::open(const char* path, uint64_t start_cycle) {
+	file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	used = 0;
+	last_cycle = start_cycle;
+	put_header(start_cycle);
+	return true;
+}
+
+void InputRecorder::close(uint64_t end_cycle) {
+	if (!file) {
+		return;
+	}
+	put_tag(end_cycle, StimulusType::End, 0);
+	flush();
+	fclose(file);
+	file = nullptr;
+}
+
+void InputRecorder::record(uint64_t cycle, StimulusType type, uint8_t arg, uint32_t value) {
+	if (!file) {
+		return;
+	}
+	put_tag(cycle, type, arg);
+	switch (type) {
+	case StimulusType::SampleIn:
+	case StimulusType::HIRInterrupt:
+		put24(value);
+		break;
+	default:
+		break;
+	}
+}
+
+void InputRecorder::record_bus_in(uint64_t cycle, uint32_t address, uint32_t value) {
+	if (!file) {
+		return;
+	}
+	put_tag(cycle, StimulusType::BusIn, 0);
+	put24(address);
+	put24(value);
+}
+
+void InputRecorder::put_header(uint64_t start_cycle) {
+	for (uint8_t byte : INPUT_LOG_MAGIC) {
+		buffer[used++] = byte;
+	}
+	buffer[used++] = INPUT_LOG_VERSION & 0xFF;
+	buffer[used++] = INPUT_LOG_VERSION >> 8;
+	buffer[used++] = 0;
+	buffer[used++] = 0;
+	for (int i = 0; i < 8; i++) {
+		buffer[used++] = (uint8_t)(start_cycle >> (i * 8));
+	}
+}
+
+void InputRecorder::put_tag(uint64_t cycle, StimulusType type, uint8_t arg) {
+	//Largest record is 10 (varint) + 1 (tag) + 6 (payload) bytes
+	if (used > BUFFER_SIZE - 17) {
+		flush();
+	}
+	assert(cycle >= last_cycle); //Stimuli must be recorded in order
+	assert(arg < 0x10);
+	put_varint(cycle - last_cycle);
+	last_cycle = cycle;
+	buffer[used++] = (uint8_t)type | (arg << 4);
+}
+
+void InputRecorder::put_varint(uint64_t value) {
+	while (value >= 0x80) {
+		buffer[used++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buffer[used++] = (uint8_t)value;
+}
+
+void InputRecorder::put24(uint32_t value) {
+	buffer[used++] = (uint8_t)value;
+	buffer[used++] = (uint8_t)(value >> 8);
+	buffer[used++] = (uint8_t)(value >> 16);
+}
+
+void InputRecorder::flush() {
+	fwrite(buffer, 1, used, file);
+	used = 0;
+}
+
+bool InputReplayer::open(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length < (long)INPUT_LOG_HEADER_SIZE) {
+		fclose(file);
+		return false;
+	}
+	log.resize(length);
+	size_t read = fread(log.data(), 1, length, file);
+	fclose(file);
+	if (read != (size_t)length) {
+		return false;
+	}
+
+	if (memcmp(log.data(), INPUT_LOG_MAGIC, 4) != 0) {
+		return false;
+	}
+	uint16_t version = log[4] | (log[5] << 8);
+	if (version != INPUT_LOG_VERSION) {
+		return false;
+	}
+	start = 0;
+	for (int i = 0; i < 8; i++) {
+		start |= (uint64_t)log[8 + i] << (i * 8);
+	}
+	end = start;
+	pos = INPUT_LOG_HEADER_SIZE;
+	return true;
+}
+
+bool InputReplayer::run(Emulator& dsp) {
+	if (dsp.cycles() != start) {
+		return false; //Emulator is not at the recording's starting point
+	}
+	pos = INPUT_LOG_HEADER_SIZE;
+	pending_bus_in.clear();
+	diverged = false;
+	dsp.set_input_replayer(this);
+
+	uint64_t cycle = start;
+	bool ok = false;
+	while (pos < log.size()) {
+		uint64_t delta;
+		if (!get_varint(&delta) || pos >= log.size()) {
+			break;
+		}
+		cycle += delta;
+		uint8_t tag = log[pos++];
+		StimulusType type = (StimulusType)(tag & 0xF);
+		uint8_t arg = tag >> 4;
+
+		if (type == StimulusType::BusIn) {
+			//Consumed while the instruction of this cycle executes
+			uint32_t address;
+			uint32_t value;
+			if (!get24(&address) || !get24(&value)) {
+				break;
+			}
+			pending_bus_in.push_back(bus_in_t{ cycle, address, (int32_t)value });
+			continue;
+		}
+
+		//Everything else is applied before the instruction of its cycle
+		dsp.run_until(cycle);
+		if (type == StimulusType::End) {
+			end = cycle;
+			ok = true;
+			break;
+		}
+
+		uint32_t value = 0;
+		switch (type) {
+		case StimulusType::SampleIn:
+			if (!get24(&value)) {
+				break;
+			}
+			dsp.sample_in((Channel)arg, (int32_t)value);
+			continue;
+		case StimulusType::HIRInterrupt:
+			if (!get24(&value)) {
+				break;
+			}
+			dsp.hir_interrupt(uint24_t{ value });
+			continue;
+		case StimulusType::ExtInterrupt:
+			dsp.ext_interrupt(arg);
+			continue;
+		case StimulusType::SetBIO:
+			dsp.set_bio(arg != 0);
+			continue;
+		case StimulusType::HIROut:
+			dsp.hir_out();
+			continue;
+		default:
+			break; //Unknown record
+		}
+		break; //Truncated or corrupt log
+	}
+
+	dsp.set_input_replayer(nullptr);
+	return ok && !diverged && pending_bus_in.empty();
+}
+
+int32_t InputReplayer::bus_in(uint64_t cycle, uint32_t address) {
+	if (pending_bus_in.empty()) {
+		diverged = true;
+		return 0;
+	}
+	bus_in_t response = pending_bus_in.front();
+	pending_bus_in.pop_front();
+	if (response.cycle != cycle || response.address != (address & UINT24_MAX)) {
+		diverged = true;
+	}
+	return response.value;
+}
+
+bool InputReplayer::get_varint(uint64_t* value) {
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= log.size()) {
+			return false;
+		}
+		uint8_t byte = log[pos++];
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool InputReplayer::get24(uint32_t* value) {
+	if (pos + 3 > log.size()) {
+		return false;
+	}
+	*value = log[pos] | (log[pos + 1] << 8) | (log[pos + 2] << 16);
+	pos += 3;
+	return true;
+}
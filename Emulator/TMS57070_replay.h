@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+namespace TMS57070 {
+
+	class Emulator;
+
+	//Stimulus log file layout:
+	//  header: "T57L", uint16 version, uint16 reserved, uint64 start cycle (little-endian)
+	//  records: varint cycle delta, uint8 tag (type | arg << 4), type-specific payload
+	//Values are 24-bit and stored as 3 little-endian bytes
+	constexpr uint16_t INPUT_LOG_VERSION = 1;
+
+	enum class StimulusType : uint8_t {
+		SampleIn, //arg: channel, payload: value
+		HIRInterrupt, //payload: value
+		ExtInterrupt, //arg: interrupt number
+		SetBIO, //arg: BIO value
+		BusIn, //payload: address, value. Response of the external bus input callback
+		HIROut, //Host read of HIR, which clears it
+		End = 0xF, //Last record: the cycle the recording stopped at
+	};
+
+	//Logs every external stimulus an Emulator receives, with its cycle timestamp.
+	//Recording must start with the emulator in a known state (e.g. straight after loading PMEM/CMEM and reset())
+	class InputRecorder {
+	public:
+		~InputRecorder();
+		bool open(const char* path, uint64_t start_cycle);
+		void close(uint64_t end_cycle);
+		void record(uint64_t cycle, StimulusType type, uint8_t arg, uint32_t value);
+		void record_bus_in(uint64_t cycle, uint32_t address, uint32_t value);
+
+	private:
+		void put_header(uint64_t start_cycle);
+		void put_tag(uint64_t cycle, StimulusType type, uint8_t arg);
+		void put_varint(uint64_t value);
+		void put24(uint32_t value);
+		void flush();
+
+		static constexpr size_t BUFFER_SIZE = 0x10000;
+		FILE* file = nullptr;
+		uint64_t last_cycle = 0;
+		size_t used = 0;
+		uint8_t buffer[BUFFER_SIZE];
+	};
+
+	//Drives an Emulator from a stimulus log at full speed, without WAV decoding or host callbacks.
+	//The emulator must be in the state the recording started from
+	class InputReplayer {
+	public:
+		bool open(const char* path);
+		bool run(Emulator& dsp); //Returns false if the log is corrupt or the emulator diverged from the recording
+		int32_t bus_in(uint64_t cycle, uint32_t address); //Recorded external bus input, consumed by the emulator
+
+		uint64_t start_cycle() { return start; }
+		uint64_t end_cycle() { return end; }
+
+	private:
+		struct bus_in_t {
+			uint64_t cycle;
+			uint32_t address;
+			int32_t value;
+		};
+
+		bool get_varint(uint64_t* value);
+		bool get24(uint32_t* value);
+
+		std::vector<uint8_t> log;
+		size_t pos = 0;
+		uint64_t start = 0;
+		uint64_t end = 0;
+		std::deque<bus_in_t> pending_bus_in; //Responses recorded for cycles not yet executed
+		bool diverged = false;
+	};
+
+}
@@ -0,0 +1,224 @@
+#include "TMS57070.h"
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+//Binary state report layout (little-endian):
+//  "T57R", uint16 version, uint16 register count (TRACE_REG_COUNT)
+//  uint64 cycle, uint32 PC
+//  uint32 registers in TraceReg order (see trace_reg_name())
+//  uint32 CMEM[512], uint32 DMEM[512], as unsigned 24-bit values
+static const uint8_t REPORT_MAGIC[4] = { 'T', '5', '7', 'R' };
+constexpr uint16_t REPORT_VERSION = 1;
+
+namespace {
+
+	//Appends to a caller's buffer without allocating. Output past the end is dropped but still counted,
+	//so the final length tells the caller how big the buffer must be, like snprintf()
+	class JsonWriter {
+	public:
+		JsonWriter(char* buffer, size_t size) : buffer(buffer), size(size) {}
+
+		void text(const char* str) {
+			while (*str) {
+				put(*str++);
+			}
+		}
+		void hex24(uint32_t value) {
+			static const char DIGITS[] = "0123456789ABCDEF";
+			if (pos + 8 <= size) { //Most words are nowhere near the end of the buffer
+				char* out = buffer + pos;
+				out[0] = '"';
+				for (int i = 0; i < 6; i++) {
+					out[1 + i] = DIGITS[(value >> (20 - i * 4)) & 0xF];
+				}
+				out[7] = '"';
+				pos += 8;
+				return;
+			}
+			put('"');
+			for (int shift = 20; shift >= 0; shift -= 4) {
+				put(DIGITS[(value >> shift) & 0xF]);
+			}
+			put('"');
+		}
+		void value(const char* name, uint32_t value) {
+			put('"');
+			text(name);
+			text("\":");
+			hex24(value);
+			put(',');
+		}
+		void array(const char* name, const int24_t* words, uint32_t count) {
+			put('"');
+			text(name);
+			text("\":[");
+			for (uint32_t i = 0; i < count; i++) {
+				if (i) {
+					put(',');
+				}
+				hex24((uint32_t)words[i].value);
+			}
+			put(']');
+		}
+		void put(char c) {
+			if (pos < size) {
+				buffer[pos] = c;
+			}
+			pos++;
+		}
+
+		size_t finish() { //Null-terminates if there is room
+			if (pos < size) {
+				buffer[pos] = '\0';
+			}
+			return pos;
+		}
+
+	private:
+		char* buffer;
+		size_t size;
+		size_t pos = 0;
+	};
+
+	class BinaryWriter {
+	public:
+		BinaryWriter(uint8_t* buffer, size_t size) : buffer(buffer), size(size) {}
+
+		void u16(uint16_t value) { put(value, 2); }
+		void u32(uint32_t value) {
+			if (pos + 4 <= size) {
+				uint8_t* out = buffer + pos;
+				out[0] = (uint8_t)value;
+				out[1] = (uint8_t)(value >> 8);
+				out[2] = (uint8_t)(value >> 16);
+				out[3] = (uint8_t)(value >> 24);
+				pos += 4;
+			} else {
+				put(value, 4);
+			}
+		}
+		void u64(uint64_t value) { put(value, 8); }
+		size_t length() { return pos; }
+
+		void put(uint64_t value, int length) {
+			if (pos + length <= size) {
+				for (int i = 0; i < length; i++) {
+					buffer[pos + i] = (uint8_t)(value >> (i * 8));
+				}
+				pos += length;
+				return;
+			}
+			for (int i = 0; i < length; i++, pos++) {
+				if (pos < size) {
+					buffer[pos] = (uint8_t)(value >> (i * 8));
+				}
+			}
+		}
+
+	private:
+		uint8_t* buffer;
+		size_t size;
+		size_t pos = 0;
+	};
+
+}
+
+//Registers and the full CMEM and DMEM as JSON, in the format of reportState().
+//Returns the length of the report. It was written completely if that is below size
+size_t Emulator::write_state_json(char* buffer, size_t size) {
+	JsonWriter out(buffer, size);
+	out.put('{');
+
+	//The keys reportState() has always had, which the hardware comparison tooling reads
+	out.value("ACC1", ACC1.value);
+	out.value("ACC2", ACC2.value);
+	out.value("MAC1", MACC1.getUpper().value);
+	out.value("MAC2", MACC2.getUpper().value);
+	out.value("MAC1L", MACC1.getLower().value);
+	out.value("MAC2L", MACC2.getLower().value);
+	out.value("CA1", CA.one.value);
+	out.value("CA2", CA.two.value);
+	out.value("DA1", DA.one.value);
+	out.value("DA2", DA.two.value);
+	out.value("XRD", XRD.value);
+	out.value("CR0", CR0.value);
+	out.value("CR1", CR1.value);
+	out.value("CR2", CR2.value);
+	out.value("CR3", CR3.value);
+	out.value("CIR1", CIR.one.value);
+	out.value("CIR2", CIR.two.value);
+	out.value("DIR1", DIR.one.value);
+	out.value("DIR2", DIR.two.value);
+
+	out.value("T", T.value);
+	out.value("HIR", HIR.value);
+	out.value("AR1L", AR1L.value);
+	out.value("AR1R", AR1R.value);
+	out.value("AR2L", AR2L.value);
+	out.value("AR2R", AR2R.value);
+	out.value("AX1L", AX1L.value);
+	out.value("AX1R", AX1R.value);
+	out.value("AX2L", AX2L.value);
+	out.value("AX2R", AX2R.value);
+	out.value("AX3L", AX3L.value);
+	out.value("AX3R", AX3R.value);
+	out.value("COFF", COFF.value);
+	out.value("CCIRC", CCIRC.value);
+	out.value("DOFF", DOFF.value);
+	out.value("DCIRC", DCIRC.value);
+	out.value("XOFF", XOFF);
+	out.value("GOFF", GOFF.value);
+	out.value("PC", PC.value);
+	out.value("SP", SP);
+	out.value("RPTC", RPTC);
+
+	out.array("CMEM", CMEM, 512);
+	out.put(',');
+	out.array("DMEM", DMEM, 512);
+	out.put('}');
+	return out.finish();
+}
+
+//Writes write_state_json() to a stream, using a buffer on the stack
+bool Emulator::write_state_json(FILE* out) {
+	char buffer[STATE_JSON_MAX];
+	size_t length = write_state_json(buffer, sizeof(buffer));
+	assert(length < sizeof(buffer)); //STATE_JSON_MAX is too small
+	return fwrite(buffer, 1, length, out) == length;
+}
+
+//Registers and the full CMEM and DMEM in a fixed binary layout of STATE_BINARY_SIZE bytes.
+//Returns the length of the report. It was written completely if that is no more than size
+size_t Emulator::write_state_binary(uint8_t* buffer, size_t size) {
+	BinaryWriter out(buffer, size);
+	for (uint8_t c : REPORT_MAGIC) {
+		out.put(c, 1);
+	}
+	out.u16(REPORT_VERSION);
+	out.u16(TRACE_REG_COUNT);
+	out.u64(cycle);
+	out.u32(PC.value);
+
+	uint32_t values[TRACE_REG_COUNT];
+	register_values(values);
+	for (uint32_t value : values) {
+		out.u32(value);
+	}
+	for (const int24_t& word : CMEM) {
+		out.u32((uint32_t)word.value & UINT24_MAX);
+	}
+	for (const int24_t& word : DMEM) {
+		out.u32((uint32_t)word.value & UINT24_MAX);
+	}
+	assert(out.length() == STATE_BINARY_SIZE);
+	return out.length();
+}
+
+//Returns a JSON string with CMEM, DMEM, and all the registers
+std::string Emulator::reportState() {
+	std::string report(STATE_JSON_MAX, '\0');
+	report.resize(write_state_json(&report[0], report.size()));
+	return report;
+}
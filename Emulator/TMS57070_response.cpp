@@ -0,0 +1,166 @@
+#include "TMS57070_response.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace TMS57070;
+
+static const double PI = 3.14159265358979323846;
+static const int32_t IMPULSE_AMPLITUDE = 0x400000; //Half of full scale
+static const double SWEEP_AMPLITUDE = 0.25;
+static const double RESPONSE_THRESHOLD = 1e-4; //Peak of the impulse response below which an output did not respond
+
+static const char* CHANNEL_NAMES[] = { "in_1L", "in_1R", "in_2L", "in_2R", "out_1L", "out_1R", "out_2L", "out_2R", "out_3L", "out_3R" };
+
+static int32_t clamp_sample(int64_t value) {
+	return (int32_t)std::min<int64_t>(std::max<int64_t>(value, -INT24_MAX - 1), INT24_MAX);
+}
+
+ResponseMeter::ResponseMeter(response_config_t config) : config(config) {
+}
+
+std::vector<response_t> ResponseMeter::measure(Emulator& emulator, const std::vector<Channel>& inputs) {
+	uint32_t frames = config.frames;
+	std::vector<int32_t> hold_L(frames, config.hold[0]);
+	std::vector<int32_t> hold_R(frames, config.hold[1]);
+	std::vector<int32_t> baseline[6];
+	render(emulator, &hold_L, &hold_R, baseline);
+
+	//Exponential sweep from 20 Hz to just below Nyquist
+	std::vector<int32_t> sweep(frames);
+	double f1 = 20.0 / config.sample_rate, f2 = 0.45;
+	double rate = std::log(f2 / f1);
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		double phase = 2 * PI * f1 * frames / rate * (std::exp(rate * frame / frames) - 1);
+		sweep[frame] = (int32_t)(SWEEP_AMPLITUDE * INT24_MAX * std::sin(phase));
+	}
+
+	std::vector<response_t> responses;
+	for (Channel input : inputs) {
+		bool right = input == Channel::in_1R || input == Channel::in_2R;
+		std::vector<int32_t> impulse = right ? hold_R : hold_L;
+		impulse[0] = clamp_sample((int64_t)impulse[0] + IMPULSE_AMPLITUDE);
+		std::vector<int32_t> sweep_input = right ? hold_R : hold_L;
+		for (uint32_t frame = 0; frame < frames; frame++) {
+			sweep_input[frame] = clamp_sample((int64_t)sweep_input[frame] + sweep[frame]);
+		}
+
+		std::vector<int32_t> impulse_out[6], sweep_out[6];
+		render(emulator, right ? &hold_L : &impulse, right ? &impulse : &hold_R, impulse_out);
+		render(emulator, right ? &hold_L : &sweep_input, right ? &sweep_input : &hold_R, sweep_out);
+
+		for (uint32_t output = 0; output < 6; output++) {
+			response_t response{ input, (Channel)((uint32_t)Channel::out_1L + output), -1, -1, -1, 0.0, std::vector<float>(frames) };
+			float peak = 0;
+			for (uint32_t frame = 0; frame < frames; frame++) {
+				response.impulse[frame] = (float)(impulse_out[output][frame] - baseline[output][frame]) / IMPULSE_AMPLITUDE;
+				if (std::fabs(response.impulse[frame]) > peak) {
+					peak = std::fabs(response.impulse[frame]);
+					response.peak = (int32_t)frame;
+				}
+			}
+			if (peak < RESPONSE_THRESHOLD) {
+				continue;
+			}
+			for (uint32_t frame = 0; frame < frames; frame++) {
+				if (std::fabs(response.impulse[frame]) >= peak * 1e-3) {
+					response.first_arrival = (int32_t)frame;
+					break;
+				}
+			}
+
+			//Cross-correlation of the sweep with the output over the first half of the lags
+			double best = 0;
+			for (uint32_t lag = 0; lag < frames / 2; lag++) {
+				double sum = 0;
+				for (uint32_t frame = 0; frame + lag < frames; frame++) {
+					sum += (double)sweep[frame] * (sweep_out[output][frame + lag] - baseline[output][frame + lag]);
+				}
+				if (std::fabs(sum) > best) {
+					best = std::fabs(sum);
+					response.sweep_lag = (int32_t)lag;
+				}
+			}
+
+			//Group delay: phase slope between two DFT bins around 1 kHz
+			double step = (double)config.sample_rate / frames;
+			double magnitude, phase_low, phase_high;
+			dft(response.impulse, 1000.0 - step / 2, &magnitude, &phase_low);
+			dft(response.impulse, 1000.0 + step / 2, &magnitude, &phase_high);
+			double difference = std::remainder(phase_high - phase_low, 2 * PI);
+			response.group_delay = -difference / (2 * PI * step / config.sample_rate);
+
+			responses.push_back(std::move(response));
+		}
+	}
+	return responses;
+}
+
+void ResponseMeter::render(Emulator& emulator, const std::vector<int32_t>* left, const std::vector<int32_t>* right, std::vector<int32_t> outputs[6]) const {
+	std::unique_ptr<Emulator> instance = emulator.fork();
+	instance->register_sample_out_callback(nullptr); //Outputs go to the block only
+
+	audio_block_t block{ left->data(), right->data(), {}, config.frames };
+	for (uint32_t output = 0; output < 6; output++) {
+		outputs[output].assign(config.frames, 0);
+		block.out[output] = outputs[output].data();
+	}
+	instance->run_block(config.port, block);
+}
+
+void ResponseMeter::dft(const std::vector<float>& samples, double frequency, double* magnitude, double* phase) const {
+	double omega = 2 * PI * frequency / config.sample_rate;
+	double re = 0, im = 0;
+	for (size_t frame = 0; frame < samples.size(); frame++) {
+		re += samples[frame] * std::cos(omega * frame);
+		im -= samples[frame] * std::sin(omega * frame);
+	}
+	*magnitude = std::sqrt(re * re + im * im);
+	*phase = std::atan2(im, re);
+}
+
+void ResponseMeter::print(const std::vector<response_t>& responses, FILE* out) const {
+	if (responses.empty()) {
+		fprintf(out, "No output responded\n");
+	}
+	for (const response_t& response : responses) {
+		fprintf(out, "%s -> %s: first arrival %d, peak %d, sweep %d, group delay at 1 kHz %.1f samples\n",
+			CHANNEL_NAMES[(int)response.input], CHANNEL_NAMES[(int)response.output],
+			response.first_arrival, response.peak, response.sweep_lag, response.group_delay);
+	}
+}
+
+bool ResponseMeter::write_impulses(const std::vector<response_t>& responses, FILE* out) const {
+	bool ok = fprintf(out, "frame") > 0;
+	for (const response_t& response : responses) {
+		ok = ok && fprintf(out, ",%s->%s", CHANNEL_NAMES[(int)response.input], CHANNEL_NAMES[(int)response.output]) > 0;
+	}
+	ok = ok && fprintf(out, "\n") > 0;
+	for (uint32_t frame = 0; frame < config.frames && ok; frame++) {
+		ok = fprintf(out, "%u", frame) > 0;
+		for (const response_t& response : responses) {
+			ok = ok && fprintf(out, ",%.9g", response.impulse[frame]) > 0;
+		}
+		ok = ok && fprintf(out, "\n") > 0;
+	}
+	return ok;
+}
+
+bool ResponseMeter::write_frequency_responses(const std::vector<response_t>& responses, FILE* out) const {
+	bool ok = fprintf(out, "frequency") > 0;
+	for (const response_t& response : responses) {
+		const char* input = CHANNEL_NAMES[(int)response.input];
+		const char* output = CHANNEL_NAMES[(int)response.output];
+		ok = ok && fprintf(out, ",%s->%s dB,%s->%s phase", input, output, input, output) > 0;
+	}
+	ok = ok && fprintf(out, "\n") > 0;
+	for (double frequency = 20.0; frequency < config.sample_rate / 2.0 && ok; frequency *= std::pow(2.0, 1.0 / 12)) {
+		ok = fprintf(out, "%.2f", frequency) > 0;
+		for (const response_t& response : responses) {
+			double magnitude, phase;
+			dft(response.impulse, frequency, &magnitude, &phase);
+			ok = ok && fprintf(out, ",%.3f,%.4f", 20 * std::log10(std::max(magnitude, 1e-12)), phase) > 0;
+		}
+		ok = ok && fprintf(out, "\n") > 0;
+	}
+	return ok;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TMS57070.h"
+
+namespace TMS57070 {
+
+	struct response_config_t {
+		AudioPort port;
+		uint32_t sample_rate; //Of the port, for frequencies
+		uint32_t frames; //Length of each measurement
+		int32_t hold[2]; //Left and right input while the other one is measured, e.g. a pedal position on in_1R
+	};
+
+	//Response of one output to one input
+	struct response_t {
+		Channel input;
+		Channel output;
+		int32_t first_arrival; //Frames from the impulse to the first output within 60 dB of the peak. -1 if the output did not respond
+		int32_t peak; //Frames from the impulse to the largest output
+		int32_t sweep_lag; //Lag of the largest cross-correlation of the sweep input and output, robust to nonlinear programs
+		double group_delay; //Frames, from the phase of the impulse response around 1 kHz
+		std::vector<float> impulse; //Output per unit input, minus the output without input
+	};
+
+	//Measures the latency and the impulse and frequency responses of a program through run_block(), with no
+	//observers attached. Each measurement runs on a fork() of the emulator, so all of them start from the same
+	//state and the emulator itself is not advanced. The output without input is measured too and subtracted,
+	//so that idle noise, oscillators and offsets of the program do not count as response
+	class ResponseMeter {
+	public:
+		ResponseMeter(response_config_t config);
+		std::vector<response_t> measure(Emulator& emulator, const std::vector<Channel>& inputs); //Only outputs that responded are returned
+
+		void print(const std::vector<response_t>& responses, FILE* out) const;
+		bool write_impulses(const std::vector<response_t>& responses, FILE* out) const; //CSV, one column per response
+		bool write_frequency_responses(const std::vector<response_t>& responses, FILE* out) const; //CSV of magnitude (dB) and phase per response, 1/12 octave steps
+
+	private:
+		void render(Emulator& emulator, const std::vector<int32_t>* left, const std::vector<int32_t>* right, std::vector<int32_t> outputs[6]) const;
+		void dft(const std::vector<float>& samples, double frequency, double* magnitude, double* phase) const;
+
+		response_config_t config;
+	};
+
+}
@@ -0,0 +1,241 @@
+#include "TMS57070_shadow.h"
+#include <algorithm>
+
+using namespace TMS57070;
+
+ShadowRunner::ShadowRunner(Emulator& engine, uint64_t interval) : engine(engine), interval(interval) {
+	resync();
+}
+
+void ShadowRunner::resync() {
+	reference = engine.fork();
+	reference->register_sample_out_callback(nullptr);
+	good_cycle = engine.cycles();
+	bad_cycle = 0;
+	mismatch_count = 0;
+	listed.clear();
+}
+
+void ShadowRunner::sample_in(Channel channel, int32_t value) {
+	engine.sample_in(channel, value);
+	reference->sample_in(channel, value);
+}
+
+void ShadowRunner::ext_interrupt(uint8_t interrupt) {
+	engine.ext_interrupt(interrupt);
+	reference->ext_interrupt(interrupt);
+}
+
+void ShadowRunner::hir_interrupt(uint24_t input) {
+	engine.hir_interrupt(input);
+	reference->hir_interrupt(input);
+}
+
+uint32_t ShadowRunner::hir_out() {
+	reference->hir_out();
+	return engine.hir_out();
+}
+
+void ShadowRunner::set_bio(bool value) {
+	engine.set_bio(value);
+	reference->set_bio(value);
+}
+
+bool ShadowRunner::run_until(uint64_t target_cycle) {
+	if (diverged()) {
+		return false;
+	}
+	while (engine.cycles() < target_cycle) {
+		uint64_t stop = target_cycle;
+		if (interval) {
+			//Compare at multiples of the interval, so that the checkpoints don't depend on how the host splits the run
+			stop = std::min(stop, (engine.cycles() / interval + 1) * interval);
+		}
+		engine.run_until(stop);
+		while (reference->cycles() < engine.cycles()) {
+			reference->step();
+		}
+		if (!compare()) {
+			return false;
+		}
+		if (engine.debug_stopped()) {
+			break;
+		}
+	}
+	return true;
+}
+
+bool ShadowRunner::run_sample_period(AudioPort port) {
+	if (!run_until(engine.next_sample_cycle(port))) {
+		return false;
+	}
+	engine.run_sample_period(port); //Nothing left to execute: only closes the period for the engine's sample clock and observers
+	return true;
+}
+
+bool ShadowRunner::run_block(AudioPort port, audio_block_t& block) {
+	Channel in_L = (port == AudioPort::ARI1) ? Channel::in_1L : Channel::in_2L;
+	Channel in_R = (port == AudioPort::ARI1) ? Channel::in_1R : Channel::in_2R;
+
+	//Emulator::run_block(), with the stimuli going to both emulators
+	engine.active_block = &block;
+	for (engine.block_frame = 0; engine.block_frame < block.frames; engine.block_frame++) {
+		if (block.in_L) {
+			sample_in(in_L, block.in_L[engine.block_frame]);
+		}
+		if (block.in_R) {
+			sample_in(in_R, block.in_R[engine.block_frame]);
+		}
+		if (!run_sample_period(port) || engine.debug_stopped()) {
+			block.frames = engine.block_frame; //Frames that completed
+			break;
+		}
+	}
+	engine.active_block = nullptr;
+	return !diverged();
+}
+
+void ShadowRunner::mismatch(const char* name, uint32_t addr, uint64_t engine_value, uint64_t reference_value) {
+	if (listed.size() < MAX_MISMATCHES) {
+		listed.push_back(shadow_mismatch_t{ name, addr, engine_value, reference_value });
+	}
+	mismatch_count++;
+}
+
+//Compares the complete architectural state of both emulators, which are at the same cycle
+bool ShadowRunner::compare() {
+	Emulator& lhs = engine;
+	Emulator& rhs = *reference;
+	compared++;
+
+	uint32_t lhs_registers[TRACE_REG_COUNT];
+	uint32_t rhs_registers[TRACE_REG_COUNT];
+	lhs.register_values(lhs_registers);
+	rhs.register_values(rhs_registers);
+	for (uint32_t reg = 0; reg < TRACE_REG_COUNT; reg++) {
+		if (lhs_registers[reg] != rhs_registers[reg]) {
+			mismatch(trace_reg_name((TraceReg)reg), 0, lhs_registers[reg], rhs_registers[reg]);
+		}
+	}
+
+	//State the tracer does not see
+	const struct {
+		const char* name;
+		uint64_t lhs;
+		uint64_t rhs;
+	} others[] = {
+		{ "cycle", lhs.cycle, rhs.cycle },
+		{ "PC", lhs.PC.value, rhs.PC.value },
+		{ "rep_start_PC", lhs.rep_start_PC.value, rhs.rep_start_PC.value },
+		{ "rep_end_PC", lhs.rep_end_PC.value, rhs.rep_end_PC.value },
+		{ "BIO", lhs.BIO, rhs.BIO },
+		{ "irq_poll", lhs.irq_poll, rhs.irq_poll },
+		{ "faulted", lhs.faulted, rhs.faulted },
+		{ "MACC1_delayed1", (uint64_t)lhs.MACC1_delayed1.getRaw(), (uint64_t)rhs.MACC1_delayed1.getRaw() },
+		{ "MACC2_delayed1", (uint64_t)lhs.MACC2_delayed1.getRaw(), (uint64_t)rhs.MACC2_delayed1.getRaw() },
+		{ "MACC1_delayed2", (uint64_t)lhs.MACC1_delayed2.getRaw(), (uint64_t)rhs.MACC1_delayed2.getRaw() },
+		{ "MACC2_delayed2", (uint64_t)lhs.MACC2_delayed2.getRaw(), (uint64_t)rhs.MACC2_delayed2.getRaw() },
+		{ "dual_ptr", lhs.dual_reg_id(lhs.addr_regs_pipeline.dual_ptr), rhs.dual_reg_id(rhs.addr_regs_pipeline.dual_ptr) },
+		{ "dual_value", (uint64_t)lhs.addr_regs_pipeline.dual_value.two.value << 12 | lhs.addr_regs_pipeline.dual_value.one.value,
+			(uint64_t)rhs.addr_regs_pipeline.dual_value.two.value << 12 | rhs.addr_regs_pipeline.dual_value.one.value },
+		{ "single_ptr", lhs.single_reg_id(lhs.addr_regs_pipeline.single_ptr), rhs.single_reg_id(rhs.addr_regs_pipeline.single_ptr) },
+		{ "single_value", lhs.addr_regs_pipeline.single_value.value, rhs.addr_regs_pipeline.single_value.value },
+		{ "dual_ptr_delayed1", lhs.dual_reg_id(lhs.addr_regs_pipeline.dual_ptr_delayed1), rhs.dual_reg_id(rhs.addr_regs_pipeline.dual_ptr_delayed1) },
+		{ "dual_value_delayed1", (uint64_t)lhs.addr_regs_pipeline.dual_value_delayed1.two.value << 12 | lhs.addr_regs_pipeline.dual_value_delayed1.one.value,
+			(uint64_t)rhs.addr_regs_pipeline.dual_value_delayed1.two.value << 12 | rhs.addr_regs_pipeline.dual_value_delayed1.one.value },
+		{ "single_ptr_delayed1", lhs.single_reg_id(lhs.addr_regs_pipeline.single_ptr_delayed1), rhs.single_reg_id(rhs.addr_regs_pipeline.single_ptr_delayed1) },
+		{ "single_value_delayed1", lhs.addr_regs_pipeline.single_value_delayed1.value, rhs.addr_regs_pipeline.single_value_delayed1.value },
+	};
+	for (auto& other : others) {
+		if (other.lhs != other.rhs) {
+			mismatch(other.name, 0, other.lhs, other.rhs);
+		}
+	}
+	for (uint32_t i = 0; i < 4; i++) {
+		if (lhs.stack[i].value != rhs.stack[i].value) {
+			mismatch("stack", i, lhs.stack[i].value, rhs.stack[i].value);
+		}
+	}
+
+	//Pending events. Both queues saw the same pushes and pops, so their heaps have the same layout
+	const std::vector<event_t>& lhs_events = lhs.events.pending();
+	const std::vector<event_t>& rhs_events = rhs.events.pending();
+	if (lhs_events.size() != rhs_events.size()) {
+		mismatch("events", 0, lhs_events.size(), rhs_events.size());
+	} else {
+		for (uint32_t i = 0; i < lhs_events.size(); i++) {
+			const event_t& a = lhs_events[i];
+			const event_t& b = rhs_events[i];
+			if (a.cycle != b.cycle) {
+				mismatch("event cycle", i, a.cycle, b.cycle);
+			} else if (a.type != b.type || a.arg != b.arg || a.addr != b.addr || a.value != b.value) {
+				//type, arg, addr and value packed into one number
+				mismatch("event", i, (uint64_t)a.type << 56 | (uint64_t)a.arg << 48 | (uint64_t)a.addr << 24 | ((uint32_t)a.value & UINT24_MAX),
+					(uint64_t)b.type << 56 | (uint64_t)b.arg << 48 | (uint64_t)b.addr << 24 | ((uint32_t)b.value & UINT24_MAX));
+			}
+		}
+	}
+
+	//Memories
+	for (uint32_t addr = 0; addr < 512; addr++) {
+		if (lhs.PMEM[addr] != rhs.PMEM[addr]) {
+			mismatch("PMEM", addr, lhs.PMEM[addr], rhs.PMEM[addr]);
+		}
+	}
+	for (uint32_t addr = 0; addr < 512; addr++) {
+		if (lhs.CMEM[addr].value != rhs.CMEM[addr].value) {
+			mismatch("CMEM", addr, (uint32_t)lhs.CMEM[addr].value & UINT24_MAX, (uint32_t)rhs.CMEM[addr].value & UINT24_MAX);
+		}
+	}
+	for (uint32_t addr = 0; addr < 512; addr++) {
+		if (lhs.DMEM[addr].value != rhs.DMEM[addr].value) {
+			mismatch("DMEM", addr, (uint32_t)lhs.DMEM[addr].value & UINT24_MAX, (uint32_t)rhs.DMEM[addr].value & UINT24_MAX);
+		}
+	}
+	for (uint32_t addr = 0; addr < 256; addr++) {
+		if (lhs.GMEM[addr].value != rhs.GMEM[addr].value) {
+			mismatch("GMEM", addr, (uint32_t)lhs.GMEM[addr].value & UINT24_MAX, (uint32_t)rhs.GMEM[addr].value & UINT24_MAX);
+		}
+	}
+	for (uint32_t page_index = 0; page_index < lhs.XMEM.page_count(); page_index++) {
+		const int32_t* lhs_page = lhs.XMEM.page(page_index);
+		const int32_t* rhs_page = rhs.XMEM.page(page_index);
+		if (lhs_page == rhs_page) {
+			continue; //Still shared, or never written by either
+		}
+		uint32_t page_base = page_index << PagedMemory::PAGE_BITS;
+		for (uint32_t offset = 0; offset < PagedMemory::PAGE_WORDS; offset++) {
+			int32_t lhs_word = lhs_page ? lhs_page[offset] : 0;
+			int32_t rhs_word = rhs_page ? rhs_page[offset] : 0;
+			if (lhs_word != rhs_word) {
+				mismatch("XMEM", page_base + offset, (uint32_t)lhs_word & UINT24_MAX, (uint32_t)rhs_word & UINT24_MAX);
+			}
+		}
+	}
+
+	if (mismatch_count) {
+		bad_cycle = lhs.cycle;
+		return false;
+	}
+	good_cycle = lhs.cycle;
+	return true;
+}
+
+void ShadowRunner::print(FILE* out) const {
+	if (!diverged()) {
+		fprintf(out, "Shadow execution: %llu comparisons up to cycle %llu, no mismatch\n", (unsigned long long)compared, (unsigned long long)good_cycle);
+		return;
+	}
+	fprintf(out, "Shadow execution diverged between cycle %llu and %llu, at PC %03X: %llu mismatches\n",
+		(unsigned long long)good_cycle, (unsigned long long)bad_cycle, engine.PC.value, (unsigned long long)mismatch_count);
+	fprintf(out, "%-22s %8s %16s %16s\n", "", "addr", "engine", "reference");
+	for (const shadow_mismatch_t& entry : listed) {
+		fprintf(out, "%-22s %8X %16llX %16llX\n", entry.name, entry.addr, (unsigned long long)entry.engine, (unsigned long long)entry.reference);
+	}
+	if (mismatch_count > listed.size()) {
+		fprintf(out, "... %llu more\n", (unsigned long long)(mismatch_count - listed.size()));
+	}
+	if (bad_cycle - good_cycle > 1) {
+		fprintf(out, "Run with an interval of 1 to find the instruction\n");
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "TMS57070.h"
+
+namespace TMS57070 {
+
+	//One architectural value that differs between the engine and the reference
+	struct shadow_mismatch_t {
+		const char* name; //Register or memory name, e.g. "ACC1", "DMEM", "stack", "event"
+		uint32_t addr; //Word address for memories, index for the stack and events. 0 for registers
+		uint64_t engine;
+		uint64_t reference;
+	};
+
+	//Shadow execution: validates the batched run_until() engine against the reference step() interpreter.
+	//The reference is a fork() of the engine that is clocked one step() at a time, with no observers and no
+	//sample output callback. Every interval cycles, and at the end of every run call, both are brought to the
+	//same cycle and their complete architectural state is compared: registers, MACC and addressing pipelines,
+	//stack, pending events, PMEM, CMEM, DMEM, GMEM and XMEM. XMEM pages still shared since the fork are skipped.
+	//Audio outputs are not compared, as they are computed from that state.
+	//On the first mismatch the runner stops: the run calls return false and do nothing from then on.
+	//All stimuli must go through the runner so that both emulators get them at the same cycle. After writing the
+	//engine's memory or registers directly, call resync()
+	class ShadowRunner {
+	public:
+		static constexpr size_t MAX_MISMATCHES = 32; //Listed per comparison, the rest are only counted
+
+		ShadowRunner(Emulator& engine, uint64_t interval = 0); //interval: cycles between comparisons. 0 to compare only at the end of each run call
+		void resync(); //Fork a new reference from the engine
+
+		//Stimuli, delivered to both emulators
+		void sample_in(Channel channel, int32_t value);
+		void ext_interrupt(uint8_t interrupt);
+		void hir_interrupt(uint24_t input);
+		uint32_t hir_out(); //The engine's value
+		void set_bio(bool value);
+
+		//Like the Emulator functions. False once the emulators diverged
+		bool run_until(uint64_t target_cycle);
+		bool run_sample_period(AudioPort port);
+		bool run_block(AudioPort port, audio_block_t& block);
+
+		bool diverged() const { return mismatch_count != 0; }
+		uint64_t comparisons() const { return compared; }
+		uint64_t last_good_cycle() const { return good_cycle; } //Cycle of the last comparison that matched
+		uint64_t mismatch_cycle() const { return bad_cycle; } //The emulators diverged in an instruction after last_good_cycle() and up to this cycle
+		const std::vector<shadow_mismatch_t>& mismatches() const { return listed; }
+		void print(FILE* out) const;
+
+		Emulator& reference_emulator() { return *reference; }
+
+	private:
+		bool compare();
+		void mismatch(const char* name, uint32_t addr, uint64_t engine_value, uint64_t reference_value);
+
+		Emulator& engine;
+		std::unique_ptr<Emulator> reference;
+		uint64_t interval;
+		uint64_t compared = 0;
+		uint64_t good_cycle = 0;
+		uint64_t bad_cycle = 0;
+		uint64_t mismatch_count = 0;
+		std::vector<shadow_mismatch_t> listed;
+	};
+
+}
@@ -0,0 +1,582 @@
+#include "TMS57070.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+//State blob layout (little-endian):
+//  "T57S", uint16 version, uint16 reserved
+//  registers, pipelines, repeat state, stack, clocks and pending events, in the order of save_state()
+//  PMEM, CMEM, DMEM, GMEM in full
+//  XMEM as runs of non-zero words: uint32 run count, then per run uint32 start, uint32 length, words
+static const uint8_t STATE_MAGIC[4] = { 'T', '5', '7', 'S' };
+constexpr uint16_t STATE_VERSION = 1;
+
+//Zero gaps shorter than this are stored inside an XMEM run rather than starting a new one
+constexpr uint32_t XMEM_RUN_MIN_GAP = 4;
+
+//Sizes of the fixed-length sections, for checking a blob before loading it. Must follow save_state()
+constexpr size_t STATE_HEADER_BYTES = 8; //Magic, version, reserved
+constexpr size_t STATE_REGISTERS_BYTES = 186; //Control registers up to the addressing regs pipeline
+constexpr size_t STATE_CLOCKS_BYTES = 2 * 16 + 1; //Both sample clocks and irq_poll
+constexpr size_t STATE_MEMORIES_BYTES = 512 * 4 + 512 * 3 + 512 * 3 + 256 * 3; //PMEM, CMEM, DMEM, GMEM
+
+namespace {
+
+	class StateWriter {
+	public:
+		StateWriter(std::vector<uint8_t>& blob) : blob(blob) {}
+
+		void u8(uint8_t value) { blob.push_back(value); }
+		void u16(uint16_t value) { put(value, 2); }
+		void u24(uint32_t value) { put(value, 3); }
+		void u32(uint32_t value) { put(value, 4); }
+		void u64(uint64_t value) { put(value, 8); }
+		void bytes(const void* data, size_t size) {
+			const uint8_t* ptr = (const uint8_t*)data;
+			blob.insert(blob.end(), ptr, ptr + size);
+		}
+
+	private:
+		void put(uint64_t value, int size) {
+			for (int i = 0; i < size; i++) {
+				blob.push_back((uint8_t)(value >> (i * 8)));
+			}
+		}
+
+		std::vector<uint8_t>& blob;
+	};
+
+	class StateReader {
+	public:
+		StateReader(const uint8_t* blob, size_t size) : blob(blob), size(size) {}
+
+		uint8_t u8() { return (uint8_t)get(1); }
+		uint16_t u16() { return (uint16_t)get(2); }
+		uint32_t u24() { return (uint32_t)get(3); }
+		uint32_t u32() { return (uint32_t)get(4); }
+		uint64_t u64() { return get(8); }
+		void bytes(void* data, size_t length) {
+			if (length > size - pos) {
+				overrun = true;
+				return;
+			}
+			memcpy(data, blob + pos, length);
+			pos += length;
+		}
+		void skip(size_t length) {
+			if (length > size - pos) {
+				overrun = true;
+				return;
+			}
+			pos += length;
+		}
+
+		bool ok() { return !overrun; }
+		bool done() { return pos == size; }
+
+	private:
+		uint64_t get(int length) {
+			if (pos + length > size) {
+				overrun = true;
+				return 0;
+			}
+			uint64_t value = 0;
+			for (int i = 0; i < length; i++) {
+				value |= (uint64_t)blob[pos + i] << (i * 8);
+			}
+			pos += length;
+			return value;
+		}
+
+		const uint8_t* blob;
+		size_t size;
+		size_t pos = 0;
+		bool overrun = false;
+	};
+
+}
+
+static void save_mac(StateWriter& out, MAC& mac) {
+	out.u64(mac.getRaw());
+	out.u16(mac.output_shift);
+	out.u8(mac.bit_count);
+}
+
+static void load_mac(StateReader& in, MAC& mac) {
+	mac.set(in.u64());
+	mac.output_shift = (int16_t)in.u16();
+	mac.bit_count = in.u8();
+}
+
+static void save_clock(StateWriter& out, SampleClock& sample_clock) {
+	out.u64(sample_clock.origin_cycle());
+	out.u64(sample_clock.samples());
+}
+
+static void load_clock(StateReader& in, SampleClock& sample_clock) {
+	uint64_t origin = in.u64();
+	sample_clock.start(origin);
+	sample_clock.set_samples(in.u64());
+}
+
+//Addressing pipeline pointers are stored as register IDs. 0 is null
+uint8_t Emulator::dual_reg_id(addr_reg_t* reg) {
+	addr_reg_t* regs[] = { &DA, &DIR, &CA, &CIR };
+	for (uint8_t i = 0; i < 4; i++) {
+		if (reg == regs[i]) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+addr_reg_t* Emulator::dual_reg_from_id(uint8_t id) {
+	addr_reg_t* regs[] = { nullptr, &DA, &DIR, &CA, &CIR };
+	return id < 5 ? regs[id] : nullptr;
+}
+
+uint8_t Emulator::single_reg_id(uint12_t* reg) {
+	uint12_t* regs[] = { &DA.one, &DA.two, &DIR.one, &DIR.two, &CA.one, &CA.two, &CIR.one, &CIR.two };
+	for (uint8_t i = 0; i < 8; i++) {
+		if (reg == regs[i]) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+uint12_t* Emulator::single_reg_from_id(uint8_t id) {
+	uint12_t* regs[] = { nullptr, &DA.one, &DA.two, &DIR.one, &DIR.two, &CA.one, &CA.two, &CIR.one, &CIR.two };
+	return id < 9 ? regs[id] : nullptr;
+}
+
+//Serializes the complete architectural and emulator state into blob
+void Emulator::save_state(std::vector<uint8_t>& blob) {
+	blob.clear();
+	StateWriter out(blob);
+	out.bytes(STATE_MAGIC, 4);
+	out.u16(STATE_VERSION);
+	out.u16(0);
+
+	//Control registers and program flow
+	out.u24(CR0.value);
+	out.u24(CR1.value);
+	out.u24(CR2.value);
+	out.u24(CR3.value);
+	out.u16(PC.value);
+	out.u8(SP);
+	for (uint9_t& entry : stack) {
+		out.u16(entry.value);
+	}
+	out.u16(rep_start_PC.value);
+	out.u16(rep_end_PC.value);
+	out.u8(RPTC);
+
+	//MACCs and their pipeline
+	save_mac(out, MACC1);
+	save_mac(out, MACC2);
+	save_mac(out, MACC1_delayed1);
+	save_mac(out, MACC2_delayed1);
+	save_mac(out, MACC1_delayed2);
+	save_mac(out, MACC2_delayed2);
+
+	//24-bit registers
+	int24_t* regs24[] = { &ACC1, &ACC2, &XRD, &T, &AR1L, &AR1R, &AR2L, &AR2R, &AX1L, &AX1R, &AX2L, &AX2R, &AX3L, &AX3R };
+	for (int24_t* reg : regs24) {
+		out.u24(reg->value);
+	}
+	out.u24(HIR.value);
+
+	//Addressing
+	addr_reg_t* addr_regs[] = { &CA, &DA, &CIR, &DIR };
+	for (addr_reg_t* reg : addr_regs) {
+		out.u16(reg->one.value);
+		out.u16(reg->two.value);
+	}
+	out.u16(COFF.value);
+	out.u16(CCIRC.value);
+	out.u16(DOFF.value);
+	out.u16(DCIRC.value);
+	out.u32(XOFF);
+	out.u16(GOFF.value);
+	out.u8(BIO);
+
+	//Addressing regs pipeline
+	out.u8(dual_reg_id(addr_regs_pipeline.dual_ptr));
+	out.u16(addr_regs_pipeline.dual_value.one.value);
+	out.u16(addr_regs_pipeline.dual_value.two.value);
+	out.u8(single_reg_id(addr_regs_pipeline.single_ptr));
+	out.u16(addr_regs_pipeline.single_value.value);
+	out.u8(dual_reg_id(addr_regs_pipeline.dual_ptr_delayed1));
+	out.u16(addr_regs_pipeline.dual_value_delayed1.one.value);
+	out.u16(addr_regs_pipeline.dual_value_delayed1.two.value);
+	out.u8(single_reg_id(addr_regs_pipeline.single_ptr_delayed1));
+	out.u16(addr_regs_pipeline.single_value_delayed1.value);
+
+	//Timing
+	out.u64(cycle);
+	out.u32(clock.dsp_clock_hz);
+	out.u32(clock.ari1_sample_rate);
+	out.u32(clock.ari2_sample_rate);
+	save_clock(out, ari1_clock);
+	save_clock(out, ari2_clock);
+	out.u8(irq_poll);
+
+	//Pending events, earliest first so that same-cycle order survives
+	std::vector<event_t> pending = events.pending();
+	std::sort(pending.begin(), pending.end(), [](const event_t& lhs, const event_t& rhs) {
+		return lhs.cycle != rhs.cycle ? lhs.cycle < rhs.cycle : lhs.seq < rhs.seq;
+	});
+	out.u32((uint32_t)pending.size());
+	for (event_t& event : pending) {
+		out.u64(event.cycle);
+		out.u8((uint8_t)event.type);
+		out.u8(event.arg);
+		out.u32(event.addr);
+		out.u32(event.value);
+	}
+
+	//Memories
+	for (uint32_t word : PMEM) {
+		out.u32(word);
+	}
+	for (int24_t& word : CMEM) {
+		out.u24(word.value);
+	}
+	for (int24_t& word : DMEM) {
+		out.u24(word.value);
+	}
+	for (int24_t& word : GMEM) {
+		out.u24(word.value);
+	}
+
+	//XMEM is mostly empty, so only store runs of non-zero words from pages that were written
+	size_t run_count_pos = blob.size();
+	out.u32(0);
+	uint32_t run_count = 0;
+	for (uint32_t page_index = 0; page_index < XMEM.page_count(); page_index++) {
+		const int32_t* page = XMEM.page(page_index);
+		if (!page) {
+			continue;
+		}
+		uint32_t page_base = page_index << PagedMemory::PAGE_BITS;
+		uint32_t offset = 0;
+		while (offset < PagedMemory::PAGE_WORDS) {
+			if (page[offset] == 0) {
+				offset++;
+				continue;
+			}
+			uint32_t start = offset;
+			uint32_t end = offset + 1; //One past the last non-zero word
+			for (offset = end; offset < PagedMemory::PAGE_WORDS && offset - end < XMEM_RUN_MIN_GAP; offset++) {
+				if (page[offset] != 0) {
+					end = offset + 1;
+				}
+			}
+			out.u32(page_base + start);
+			out.u32(end - start);
+			for (uint32_t i = start; i < end; i++) {
+				out.u24(page[i]);
+			}
+			run_count++;
+			offset = end;
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		blob[run_count_pos + i] = (uint8_t)(run_count >> (i * 8));
+	}
+}
+
+//Walks a blob without loading it: header, section lengths, the values that index arrays or memories (SP, events,
+//XMEM runs) and the clock
+static bool state_valid(const uint8_t* blob, size_t size, uint32_t xmem_size) {
+	StateReader in(blob, size);
+	uint8_t magic[4];
+	in.bytes(magic, 4);
+	if (!in.ok() || memcmp(magic, STATE_MAGIC, 4) != 0) {
+		return false;
+	}
+	if (in.u16() != STATE_VERSION) {
+		return false;
+	}
+	in.u16();
+
+	in.skip(4 * 3 + 2); //CR0-CR3, PC
+	uint8_t SP = in.u8();
+	if (!in.ok() || SP > 4) {
+		return false;
+	}
+	in.skip(STATE_REGISTERS_BYTES - (4 * 3 + 2 + 1));
+	in.u64(); //cycle
+	uint32_t dsp_clock_hz = in.u32();
+	uint32_t ari1_sample_rate = in.u32();
+	uint32_t ari2_sample_rate = in.u32();
+	if (!in.ok() || ari1_sample_rate == 0 || ari2_sample_rate == 0 || dsp_clock_hz < ari1_sample_rate || dsp_clock_hz < ari2_sample_rate) {
+		return false; //SampleClock::configure() asserts on these
+	}
+	in.skip(STATE_CLOCKS_BYTES);
+
+	uint32_t event_count = in.u32();
+	for (uint32_t i = 0; i < event_count && in.ok(); i++) {
+		in.u64(); //cycle
+		uint8_t type = in.u8();
+		uint8_t arg = in.u8();
+		uint32_t addr = in.u32();
+		in.u32(); //value
+		if (type >= EVENT_TYPE_COUNT) {
+			return false;
+		}
+		switch ((EventType)type) {
+		case EventType::XMEMRead:
+		case EventType::XMEMWrite:
+			if (addr >= xmem_size) {
+				return false;
+			}
+			break;
+		case EventType::SampleIn:
+			if (arg > (uint8_t)Channel::in_2R) {
+				return false;
+			}
+			break;
+		case EventType::ExtInterrupt:
+			if (arg < 1 || arg > 3) {
+				return false;
+			}
+			break;
+		case EventType::HIRInterrupt:
+			break;
+		}
+	}
+	in.skip(STATE_MEMORIES_BYTES);
+
+	uint32_t run_count = in.u32();
+	for (uint32_t run = 0; run < run_count && in.ok(); run++) {
+		uint32_t start = in.u32();
+		uint32_t length = in.u32();
+		if (start > xmem_size || length > xmem_size - start) {
+			return false;
+		}
+		in.skip((size_t)length * 3);
+	}
+	return in.ok() && in.done();
+}
+
+//Restores a state produced by save_state(). Callbacks and attached recorders are kept.
+//The blob is checked in full first: an invalid one leaves the emulator untouched
+bool Emulator::load_state(const uint8_t* blob, size_t size) {
+	if (!state_valid(blob, size, XMEM.size())) {
+		return false;
+	}
+
+	StateReader in(blob, size);
+	in.skip(STATE_HEADER_BYTES);
+
+	CR0.value = in.u24();
+	CR1.value = in.u24();
+	CR2.value = in.u24();
+	CR3.value = in.u24();
+	PC.value = in.u16();
+	SP = in.u8();
+	for (uint9_t& entry : stack) {
+		entry.value = in.u16();
+	}
+	rep_start_PC.value = in.u16();
+	rep_end_PC.value = in.u16();
+	RPTC = in.u8();
+
+	load_mac(in, MACC1);
+	load_mac(in, MACC2);
+	load_mac(in, MACC1_delayed1);
+	load_mac(in, MACC2_delayed1);
+	load_mac(in, MACC1_delayed2);
+	load_mac(in, MACC2_delayed2);
+
+	int24_t* regs24[] = { &ACC1, &ACC2, &XRD, &T, &AR1L, &AR1R, &AR2L, &AR2R, &AX1L, &AX1R, &AX2L, &AX2R, &AX3L, &AX3R };
+	for (int24_t* reg : regs24) {
+		reg->value = in.u24();
+	}
+	HIR.value = in.u24();
+
+	addr_reg_t* addr_regs[] = { &CA, &DA, &CIR, &DIR };
+	for (addr_reg_t* reg : addr_regs) {
+		reg->one.value = in.u16();
+		reg->two.value = in.u16();
+	}
+	COFF.value = in.u16();
+	CCIRC.value = in.u16();
+	DOFF.value = in.u16();
+	DCIRC.value = in.u16();
+	XOFF = in.u32();
+	GOFF.value = in.u16();
+	BIO = in.u8() != 0;
+
+	addr_regs_pipeline.dual_ptr = dual_reg_from_id(in.u8());
+	addr_regs_pipeline.dual_value.one.value = in.u16();
+	addr_regs_pipeline.dual_value.two.value = in.u16();
+	addr_regs_pipeline.single_ptr = single_reg_from_id(in.u8());
+	addr_regs_pipeline.single_value.value = in.u16();
+	addr_regs_pipeline.dual_ptr_delayed1 = dual_reg_from_id(in.u8());
+	addr_regs_pipeline.dual_value_delayed1.one.value = in.u16();
+	addr_regs_pipeline.dual_value_delayed1.two.value = in.u16();
+	addr_regs_pipeline.single_ptr_delayed1 = single_reg_from_id(in.u8());
+	addr_regs_pipeline.single_value_delayed1.value = in.u16();
+
+	cycle = in.u64();
+	clock_config_t config;
+	config.dsp_clock_hz = in.u32();
+	config.ari1_sample_rate = in.u32();
+	config.ari2_sample_rate = in.u32();
+	set_clock(config);
+	load_clock(in, ari1_clock);
+	load_clock(in, ari2_clock);
+	irq_poll = in.u8() != 0;
+
+	events.clear();
+	uint32_t event_count = in.u32();
+	for (uint32_t i = 0; i < event_count; i++) {
+		event_t event{};
+		event.cycle = in.u64();
+		event.type = (EventType)in.u8();
+		event.arg = in.u8();
+		event.addr = in.u32();
+		event.value = (int32_t)in.u32();
+		events.push(event);
+	}
+	next_event_cycle = events.next_cycle();
+
+	for (uint32_t& word : PMEM) {
+		word = in.u32();
+	}
+	for (int24_t& word : CMEM) {
+		word.value = in.u24();
+	}
+	for (int24_t& word : DMEM) {
+		word.value = in.u24();
+	}
+	for (int24_t& word : GMEM) {
+		word.value = in.u24();
+	}
+
+	if (dirty) {
+		//Everything may have changed. Words zeroed by the clear are marked here, loaded words below
+		for (uint32_t addr = 0; addr < 512; addr++) {
+			dirty->CMEM.mark(addr);
+			dirty->DMEM.mark(addr);
+		}
+		mark_xmem_dirty();
+	}
+	XMEM.clear();
+	uint32_t run_count = in.u32();
+	for (uint32_t run = 0; run < run_count; run++) {
+		uint32_t start = in.u32();
+		uint32_t length = in.u32();
+		for (uint32_t i = start; i < start + length; i++) {
+			XMEM.write(i, in.u24());
+		}
+	}
+
+	if (dirty) {
+		mark_xmem_dirty();
+	}
+	if (digest) {
+		digest->set_memory(memory_digest());
+	}
+	assert(in.ok() && in.done()); //state_valid() and save_state() disagree on the layout
+	return true;
+}
+
+//Clones this instance in constant time. XMEM pages stay shared until either instance writes them.
+//Callbacks are inherited, recorders and replayers are not
+std::unique_ptr<Emulator> Emulator::fork() {
+	std::unique_ptr<Emulator> child = std::make_unique<Emulator>();
+	*child = *this; //MACs stay attached to the child, see MAC::operator=
+
+	//The addressing pipeline points at this instance's registers
+	child->addr_regs_pipeline.dual_ptr = child->dual_reg_from_id(dual_reg_id(addr_regs_pipeline.dual_ptr));
+	child->addr_regs_pipeline.single_ptr = child->single_reg_from_id(single_reg_id(addr_regs_pipeline.single_ptr));
+	child->addr_regs_pipeline.dual_ptr_delayed1 = child->dual_reg_from_id(dual_reg_id(addr_regs_pipeline.dual_ptr_delayed1));
+	child->addr_regs_pipeline.single_ptr_delayed1 = child->single_reg_from_id(single_reg_id(addr_regs_pipeline.single_ptr_delayed1));
+
+	child->detach_observers();
+	return child;
+}
+
+void Emulator::detach_observers() {
+	active_block = nullptr;
+	input_recorder = nullptr;
+	input_replayer = nullptr;
+	tracer = nullptr;
+	digest = nullptr;
+	dirty = nullptr;
+	profiler = nullptr;
+	headroom = nullptr;
+	coverage = nullptr;
+	overflow = nullptr;
+	probes = nullptr;
+	heatmap = nullptr;
+	columns = nullptr;
+	debugger = nullptr;
+	hooks = nullptr;
+	access_observed = false;
+}
+
+//Every member back to its value in a value-initialized Emulator, then reset().
+//The memories are small except XMEM, whose clear() only visits the pages that were written
+void Emulator::clear() {
+	detach_observers();
+	sample_out_cb = nullptr;
+	ext_bus_in_cb = nullptr;
+	ext_bus_out_cb = nullptr;
+	block_frame = 0;
+	fault_action = FaultAction::Assert;
+	core = CoreKind::Strict;
+
+	memset(PMEM, 0, sizeof(PMEM));
+	memset(CMEM, 0, sizeof(CMEM));
+	memset(DMEM, 0, sizeof(DMEM));
+	memset(GMEM, 0, sizeof(GMEM));
+	XMEM.clear();
+
+	memset(stack, 0, sizeof(stack));
+	rep_start_PC.value = 0;
+	rep_end_PC.value = 0;
+	MAC* macs[] = { &MACC1, &MACC2, &MACC1_delayed1, &MACC2_delayed1, &MACC1_delayed2, &MACC2_delayed2 };
+	for (MAC* mac : macs) {
+		mac->clear();
+		mac->output_shift = 0;
+		mac->bit_count = 0;
+	}
+	int24_t* regs24[] = { &ACC1, &ACC2, &XRD, &T, &AR1L, &AR1R, &AR2L, &AR2R, &AX1L, &AX1R, &AX2L, &AX2R, &AX3L, &AX3R };
+	for (int24_t* reg : regs24) {
+		reg->value = 0;
+	}
+	HIR.value = 0;
+	memset(&CA, 0, sizeof(CA));
+	memset(&DA, 0, sizeof(DA));
+	memset(&CIR, 0, sizeof(CIR));
+	memset(&DIR, 0, sizeof(DIR));
+	COFF.value = 0;
+	CCIRC.value = 0;
+	DOFF.value = 0;
+	DCIRC.value = 0;
+	XOFF = 0;
+	GOFF.value = 0;
+	BIO = false;
+
+	insn = 0;
+	opcode1 = 0;
+	opcode1_flag4 = false;
+	opcode1_flag8 = false;
+	opcode2 = 0;
+	opcode2_flag4 = false;
+	opcode2_flag8 = false;
+	opcode2_args = 0;
+	memset(&addr_regs_pipeline, 0, sizeof(addr_regs_pipeline));
+	memset(hook_registers, 0, sizeof(hook_registers));
+
+	cycle = 0;
+	set_clock(clock_config_t{ DEFAULT_DSP_CLOCK_HZ, DEFAULT_SAMPLE_RATE, DEFAULT_SAMPLE_RATE });
+	reset();
+}
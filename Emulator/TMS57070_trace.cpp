@@ -0,0 +1,198 @@
+#include "TMS57070_trace.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace TMS57070;
+
+static const uint8_t TRACE_MAGIC[4] = { 'T', '5', '7', 'T' };
+constexpr long TRACE_HEADER_SIZE = 8;
+
+static const char* TRACE_REG_NAMES[TRACE_REG_COUNT] = {
+	"ACC1", "ACC2",
+	"MAC1", "MAC1L", "MAC2", "MAC2L",
+	"XRD", "T", "HIR",
+	"AR1L", "AR1R", "AR2L", "AR2R",
+	"AX1L", "AX1R", "AX2L", "AX2R", "AX3L", "AX3R",
+	"CA", "DA", "CIR", "DIR",
+	"COFF", "CCIRC", "DOFF", "DCIRC", "XOFF", "GOFF",
+	"CR0", "CR1", "CR2", "CR3",
+	"SP", "RPTC",
+};
+
+//Trace files of long renders exceed 2 GB, more than fseek()/ftell() can address on Windows
+int TMS57070::seek64(FILE* file, uint64_t offset, int origin) {
+#ifdef _WIN32
+	return _fseeki64(file, (int64_t)offset, origin);
+#else
+	return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+uint64_t TMS57070::tell64(FILE* file) {
+#ifdef _WIN32
+	return (uint64_t)_ftelli64(file);
+#else
+	return (uint64_t)ftello(file);
+#endif
+}
+
+const char* TMS57070::trace_reg_name(TraceReg reg) {
+	return reg < TraceReg::Count ? TRACE_REG_NAMES[(int)reg] : "?";
+}
+
+bool TMS57070::trace_reg_from_name(const char* name, TraceReg* reg) {
+	for (uint32_t index = 0; index < TRACE_REG_COUNT; index++) {
+		if (strcmp(name, TRACE_REG_NAMES[index]) == 0) {
+			*reg = (TraceReg)index;
+			return true;
+		}
+	}
+	return false;
+}
+
+TraceRecorder::TraceRecorder(uint32_t capacity) {
+	uint32_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	ring.resize(size);
+	mask = size - 1;
+}
+
+TraceRecorder::~TraceRecorder() {
+	close();
+}
+
+bool TraceRecorder::open(const char* path) {
+	close();
+	file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	if (!write_header(file)) {
+		fclose(file);
+		file = nullptr;
+		return false;
+	}
+	flushed = total; //Only entries from now on
+	ok = true;
+	return true;
+}
+
+bool TraceRecorder::close() {
+	if (!file) {
+		return ok;
+	}
+	flush();
+	ok = fclose(file) == 0 && ok;
+	file = nullptr;
+	return ok;
+}
+
+//Writes out everything recorded since the last flush. Called when the ring wraps, so nothing is lost
+void TraceRecorder::flush() {
+	assert(total - flushed <= ring.size());
+	while (flushed < total) {
+		uint64_t start = flushed & mask;
+		uint64_t count = std::min<uint64_t>(total - flushed, ring.size() - start);
+		ok = ok && fwrite(&ring[start], sizeof(trace_entry_t), count, file) == count;
+		flushed += count;
+	}
+}
+
+bool TraceRecorder::save(const char* path) {
+	FILE* out = fopen(path, "wb");
+	if (!out) {
+		return false;
+	}
+	bool ok = write_header(out);
+	uint64_t count = std::min<uint64_t>(total, ring.size());
+	for (uint64_t i = total - count; i < total; i++) {
+		ok = ok && fwrite(&ring[i & mask], sizeof(trace_entry_t), 1, out) == 1;
+	}
+	return fclose(out) == 0 && ok;
+}
+
+bool TraceRecorder::write_header(FILE* out) {
+	uint8_t header[TRACE_HEADER_SIZE];
+	memcpy(header, TRACE_MAGIC, 4);
+	header[4] = TRACE_VERSION & 0xFF;
+	header[5] = TRACE_VERSION >> 8;
+	header[6] = sizeof(trace_entry_t);
+	header[7] = 0;
+	return fwrite(header, 1, TRACE_HEADER_SIZE, out) == TRACE_HEADER_SIZE;
+}
+
+TraceReader::~TraceReader() {
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool TraceReader::open(const char* path) {
+	if (file) {
+		fclose(file);
+	}
+	file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	uint8_t header[TRACE_HEADER_SIZE];
+	if (fread(header, 1, TRACE_HEADER_SIZE, file) != TRACE_HEADER_SIZE
+		|| memcmp(header, TRACE_MAGIC, 4) != 0
+		|| (header[4] | header[5] << 8) != TRACE_VERSION
+		|| header[6] != sizeof(trace_entry_t)) {
+		fclose(file);
+		file = nullptr;
+		return false;
+	}
+	seek64(file, 0, SEEK_END);
+	entry_count = (tell64(file) - TRACE_HEADER_SIZE) / sizeof(trace_entry_t);
+	seek64(file, TRACE_HEADER_SIZE, SEEK_SET);
+	return true;
+}
+
+bool TraceReader::next(trace_entry_t* entry) {
+	return file && fread(entry, sizeof(trace_entry_t), 1, file) == 1;
+}
+
+size_t TraceReader::read(trace_entry_t* entries, size_t count) {
+	return file ? fread(entries, sizeof(trace_entry_t), count, file) : 0;
+}
+
+bool TraceReader::seek(uint64_t entry) {
+	return file && entry <= entry_count && seek64(file, TRACE_HEADER_SIZE + entry * sizeof(trace_entry_t), SEEK_SET) == 0;
+}
+
+void TraceReader::print(FILE* out) {
+	static const char* MEMORY_NAMES[] = { "", "CMEM", "DMEM", "XMEM" };
+	trace_entry_t entry;
+	bool line_open = false;
+	while (next(&entry)) {
+		switch (entry.target()) {
+		case TraceTarget::Instruction:
+			if (line_open) {
+				fputc('\n', out);
+			}
+			fprintf(out, "%10llu %03X %08X", (unsigned long long)entry.cycle, entry.addr(), entry.value);
+			line_open = true;
+			break;
+		case TraceTarget::CMEM:
+		case TraceTarget::DMEM:
+		case TraceTarget::XMEM:
+			fprintf(out, " %s[%0*X]=%06X", MEMORY_NAMES[(int)entry.target()], entry.target() == TraceTarget::XMEM ? 6 : 3,
+				entry.addr(), entry.value);
+			break;
+		case TraceTarget::Register:
+			fprintf(out, " %s=%06X", trace_reg_name((TraceReg)entry.addr()), entry.value);
+			break;
+		default:
+			fprintf(out, " ?%08X=%08X", entry.location, entry.value);
+			break;
+		}
+	}
+	if (line_open) {
+		fputc('\n', out);
+	}
+}
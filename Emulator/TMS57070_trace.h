@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace TMS57070 {
+
+	//Trace file layout:
+	//  header: "T57T", uint16 version, uint16 entry size (little-endian)
+	//  entries: trace_entry_t, in execution order
+	//Entries are written in host byte order, which is little-endian on every platform the emulator targets
+	constexpr uint16_t TRACE_VERSION = 1;
+
+	enum class TraceTarget : uint8_t {
+		Instruction, //addr: PC the instruction was fetched from, value: instruction word
+		CMEM, //Memory writes. addr: word address, value: word written
+		DMEM,
+		XMEM,
+		Register, //addr: TraceReg, value: new register value
+	};
+
+	//Registers the tracer watches for changes
+	enum class TraceReg : uint8_t {
+		ACC1, ACC2,
+		MAC1, MAC1L, MAC2, MAC2L, //Raw accumulator bits 51-24 and 23-0, before the output shifter
+		XRD, T, HIR,
+		AR1L, AR1R, AR2L, AR2R,
+		AX1L, AX1R, AX2L, AX2R, AX3L, AX3R,
+		CA, DA, CIR, DIR, //two << 12 | one
+		COFF, CCIRC, DOFF, DCIRC, XOFF, GOFF,
+		CR0, CR1, CR2, CR3,
+		SP, RPTC,
+		Count,
+	};
+	constexpr uint32_t TRACE_REG_COUNT = (uint32_t)TraceReg::Count;
+	const char* trace_reg_name(TraceReg reg);
+	bool trace_reg_from_name(const char* name, TraceReg* reg); //False if no register has that name
+
+	//fseek()/ftell() with 64-bit offsets, for files of long renders
+	int seek64(FILE* file, uint64_t offset, int origin);
+	uint64_t tell64(FILE* file);
+
+	struct trace_entry_t {
+		uint64_t cycle; //Cycle of the instruction that caused this entry
+		uint32_t value;
+		uint32_t location; //TraceTarget << 24 | addr
+
+		TraceTarget target() const { return (TraceTarget)(location >> 24); }
+		uint32_t addr() const { return location & 0xFFFFFF; }
+	};
+	static_assert(sizeof(trace_entry_t) == 16, "trace_entry_t is a file format");
+
+	//Records every executed instruction and the memory and register writes it made.
+	//Entries go into a fixed ring buffer. When a file is open, the buffer is written out each time it fills,
+	//so the whole run is kept; otherwise the oldest entries are overwritten and the ring holds the most recent history
+	//(flight recorder), which save() writes out on demand.
+	//Single-threaded: the emulator that owns it is the only writer
+	class TraceRecorder {
+	public:
+		static constexpr uint32_t DEFAULT_CAPACITY = 1 << 20; //Entries, 16 MB
+
+		TraceRecorder(uint32_t capacity = DEFAULT_CAPACITY); //capacity is rounded up to a power of two
+		~TraceRecorder();
+		bool open(const char* path); //Stream all entries to a file
+		bool close(); //False if any write since open() failed
+		bool save(const char* path); //Write the ring buffer contents, oldest first
+
+		uint64_t entries() const { return total; } //Entries recorded since construction
+
+		void record(uint64_t cycle, TraceTarget target, uint32_t addr, uint32_t value) {
+			ring[total & mask] = trace_entry_t{ cycle, value, (uint32_t)target << 24 | (addr & 0xFFFFFF) };
+			total++;
+			if (file && (total & mask) == 0) {
+				flush();
+			}
+		}
+
+		//True if both byte ranges are the same as on the previous call. A cheap check before building the registers() values
+		bool unchanged(const void* data, size_t size, const void* data2, size_t size2) {
+			if (shadow.size() == size + size2 && memcmp(shadow.data(), data, size) == 0 && memcmp(shadow.data() + size, data2, size2) == 0) {
+				return true;
+			}
+			shadow.resize(size + size2);
+			memcpy(shadow.data(), data, size);
+			memcpy(shadow.data() + size, data2, size2);
+			return false;
+		}
+
+		//Emits a Register entry for every register that differs from the previous call
+		void registers(uint64_t cycle, const uint32_t values[TRACE_REG_COUNT]) {
+			for (uint32_t i = 0; i < TRACE_REG_COUNT; i++) {
+				if (values[i] != last_registers[i]) {
+					last_registers[i] = values[i];
+					record(cycle, TraceTarget::Register, i, values[i]);
+				}
+			}
+		}
+
+	private:
+		void flush();
+		bool write_header(FILE* out);
+
+		std::vector<trace_entry_t> ring;
+		uint64_t mask;
+		uint64_t total = 0;
+		uint64_t flushed = 0; //Entries already written to file
+		bool ok = true; //No write to file failed
+		uint32_t last_registers[TRACE_REG_COUNT] = {};
+		std::vector<uint8_t> shadow;
+		FILE* file = nullptr;
+	};
+
+	//Reads trace files written by TraceRecorder
+	class TraceReader {
+	public:
+		~TraceReader();
+		bool open(const char* path);
+		bool next(trace_entry_t* entry); //False at the end of the trace
+		size_t read(trace_entry_t* entries, size_t count); //Returns the number of entries read
+		bool seek(uint64_t entry); //Continue reading from this entry index
+		void print(FILE* out); //Print the remaining entries, one instruction per line
+		uint64_t size() const { return entry_count; } //Entries in the file
+
+	private:
+		FILE* file = nullptr;
+		uint64_t entry_count = 0;
+	};
+
+}
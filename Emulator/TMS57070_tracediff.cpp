@@ -0,0 +1,253 @@
+#include "TMS57070_tracediff.h"
+#include "TMS57070_disasm.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace TMS57070;
+
+bool TraceDiffer::compare(const char* path_a, const char* path_b, trace_divergence_t* result) {
+	TraceReader traces[2];
+	if (!traces[0].open(path_a) || !traces[1].open(path_b)) {
+		return false;
+	}
+
+	*result = trace_divergence_t();
+	std::vector<trace_entry_t> blocks[2];
+	blocks[0].resize(CHECKPOINT_ENTRIES);
+	blocks[1].resize(CHECKPOINT_ENTRIES);
+
+	//Register state at the start of the current and the previous checkpoint block
+	trace_divergence_t block_start = *result;
+	trace_divergence_t previous_block_start = *result;
+	uint64_t base = 0;
+	uint64_t previous_base = 0;
+	while (true) {
+		size_t counts[2];
+		counts[0] = traces[0].read(blocks[0].data(), CHECKPOINT_ENTRIES);
+		counts[1] = traces[1].read(blocks[1].data(), CHECKPOINT_ENTRIES);
+		size_t common = std::min(counts[0], counts[1]);
+		if (counts[0] == counts[1] && memcmp(blocks[0].data(), blocks[1].data(), common * sizeof(trace_entry_t)) == 0) {
+			if (common < CHECKPOINT_ENTRIES) {
+				return true; //Both traces ended together: identical
+			}
+			previous_block_start = block_start;
+			previous_base = base;
+			track_registers(blocks[0].data(), common, result);
+			memcpy(block_start.registers, result->registers, sizeof(result->registers));
+			memcpy(block_start.registers_known, result->registers_known, sizeof(result->registers_known));
+			base += common;
+			continue;
+		}
+
+		//Bisect for the first differing entry: the entries before it are equal
+		size_t low = 0; //Entries [0, low) are equal
+		size_t high = common; //First difference is at or before high
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (memcmp(blocks[0].data(), blocks[1].data(), (mid + 1) * sizeof(trace_entry_t)) == 0) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		uint64_t entry = base + low;
+		result->diverged = true;
+		result->entry = entry;
+		result->ended[0] = low >= counts[0];
+		result->ended[1] = low >= counts[1];
+		result->cycle = result->ended[0] ? blocks[1][low].cycle : blocks[0][low].cycle;
+
+		//The instruction both traces were in. If one trace starts a new instruction where the other still
+		//has writes, the divergence belongs to the earlier instruction
+		uint64_t start = std::min(instruction_start(traces[0], entry), instruction_start(traces[1], entry));
+		read_instruction(traces[0], start, &result->instruction[0], &result->writes[0]);
+		read_instruction(traces[1], start, &result->instruction[1], &result->writes[1]);
+
+		//Registers just before that instruction, replayed from the nearest checkpoint
+		uint64_t replay_from = base;
+		if (start < base) {
+			//The instruction started in the previous block (never more than one back: blocks are far longer than an instruction)
+			replay_from = previous_base;
+			memcpy(result->registers, previous_block_start.registers, sizeof(result->registers));
+			memcpy(result->registers_known, previous_block_start.registers_known, sizeof(result->registers_known));
+		}
+		std::vector<trace_entry_t> replay(start - replay_from);
+		traces[0].seek(replay_from);
+		traces[0].read(replay.data(), replay.size());
+		track_registers(replay.data(), replay.size(), result);
+		return true;
+	}
+}
+
+void TraceDiffer::track_registers(const trace_entry_t* entries, size_t count, trace_divergence_t* result) {
+	for (size_t i = 0; i < count; i++) {
+		if (entries[i].target() == TraceTarget::Register && entries[i].addr() < TRACE_REG_COUNT) {
+			result->registers[entries[i].addr()] = entries[i].value;
+			result->registers_known[entries[i].addr()] = true;
+		}
+	}
+}
+
+uint64_t TraceDiffer::instruction_start(TraceReader& trace, uint64_t entry) {
+	entry = std::min(entry, trace.size());
+	while (entry > 0) {
+		trace_entry_t candidate;
+		if (entry < trace.size() && trace.seek(entry) && trace.next(&candidate) && candidate.target() == TraceTarget::Instruction) {
+			return entry;
+		}
+		entry--;
+	}
+	return 0;
+}
+
+void TraceDiffer::read_instruction(TraceReader& trace, uint64_t start, trace_entry_t* instruction, std::vector<trace_entry_t>* writes) {
+	*instruction = trace_entry_t{ 0, 0, 0 };
+	writes->clear();
+	trace.seek(start);
+	trace_entry_t entry;
+	if (!trace.next(instruction)) {
+		return;
+	}
+	while (trace.next(&entry) && entry.target() != TraceTarget::Instruction) {
+		writes->push_back(entry);
+	}
+}
+
+bool TraceDiffer::compare_digests(const char* path_a, const char* path_b, digest_divergence_t* result) {
+	DigestReader digests[2];
+	if (!digests[0].open(path_a) || !digests[1].open(path_b)) {
+		return false;
+	}
+
+	*result = digest_divergence_t();
+	std::vector<digest_entry_t> blocks[2];
+	blocks[0].resize(CHECKPOINT_ENTRIES);
+	blocks[1].resize(CHECKPOINT_ENTRIES);
+	uint64_t base = 0;
+	while (true) {
+		size_t counts[2];
+		counts[0] = digests[0].read(blocks[0].data(), CHECKPOINT_ENTRIES);
+		counts[1] = digests[1].read(blocks[1].data(), CHECKPOINT_ENTRIES);
+		size_t common = std::min(counts[0], counts[1]);
+		size_t i = 0;
+		while (i < common && blocks[0][i].digest == blocks[1][i].digest && blocks[0][i].cycle == blocks[1][i].cycle) {
+			i++;
+		}
+		if (i == common && counts[0] == counts[1]) {
+			if (common < CHECKPOINT_ENTRIES) {
+				return true;
+			}
+			base += common;
+			continue;
+		}
+
+		result->diverged = true;
+		result->sample = base + i;
+		for (int run = 0; run < 2; run++) {
+			result->ended[run] = i >= counts[run];
+			result->cycle[run] = result->ended[run] ? 0 : blocks[run][i].cycle;
+		}
+		return true;
+	}
+}
+
+void TraceDiffer::print(const digest_divergence_t& result, FILE* out) {
+	if (!result.diverged) {
+		fprintf(out, "Digests are identical\n");
+		return;
+	}
+	fprintf(out, "Digests diverge at sample %llu\n", (unsigned long long)result.sample);
+	for (int run = 0; run < 2; run++) {
+		if (result.ended[run]) {
+			fprintf(out, "  %c: run ended\n", 'A' + run);
+		} else {
+			fprintf(out, "  %c: sample ends at cycle %llu\n", 'A' + run, (unsigned long long)result.cycle[run]);
+		}
+	}
+}
+
+static void print_location(const trace_entry_t& entry, FILE* out) {
+	static const char* MEMORY_NAMES[] = { "", "CMEM", "DMEM", "XMEM" };
+	char name[24];
+	switch (entry.target()) {
+	case TraceTarget::CMEM:
+	case TraceTarget::DMEM:
+		snprintf(name, sizeof(name), "%s[%03X]", MEMORY_NAMES[(int)entry.target()], entry.addr());
+		break;
+	case TraceTarget::XMEM:
+		snprintf(name, sizeof(name), "XMEM[%06X]", entry.addr());
+		break;
+	case TraceTarget::Register:
+		snprintf(name, sizeof(name), "%s", trace_reg_name((TraceReg)entry.addr()));
+		break;
+	default:
+		snprintf(name, sizeof(name), "?%08X", entry.location);
+		break;
+	}
+	fprintf(out, "  %-14s", name);
+}
+
+void TraceDiffer::print(const trace_divergence_t& result, FILE* out) {
+	if (!result.diverged) {
+		fprintf(out, "Traces are identical\n");
+		return;
+	}
+	fprintf(out, "Traces diverge at entry %llu, cycle %llu\n", (unsigned long long)result.entry, (unsigned long long)result.cycle);
+	for (int i = 0; i < 2; i++) {
+		const trace_entry_t& instruction = result.instruction[i];
+		if (result.ended[i] && result.writes[i].empty() && instruction.location == 0 && instruction.value == 0) {
+			fprintf(out, "  %c: trace ended\n", 'A' + i);
+			continue;
+		}
+		disasm_t decoded = disassemble(instruction.value, (uint16_t)instruction.addr());
+		fprintf(out, "  %c: %10llu %03X %08X  %s%s\n", 'A' + i, (unsigned long long)instruction.cycle, instruction.addr(),
+			instruction.value, decoded.text().c_str(), result.ended[i] ? "  (trace ends here)" : "");
+	}
+
+	//Writes of the instruction side by side, in the order trace A made them, then any only B made
+	fprintf(out, "\n  %-14s %-8s %-8s\n", "Write", "A", "B");
+	std::vector<trace_entry_t> locations = result.writes[0];
+	for (const trace_entry_t& write : result.writes[1]) {
+		bool found = std::any_of(locations.begin(), locations.end(), [&](const trace_entry_t& other) {
+			return other.location == write.location;
+		});
+		if (!found) {
+			locations.push_back(write);
+		}
+	}
+	for (const trace_entry_t& location : locations) {
+		char values[2][12];
+		bool present[2];
+		uint32_t written[2] = { 0, 0 };
+		for (int i = 0; i < 2; i++) {
+			auto it = std::find_if(result.writes[i].begin(), result.writes[i].end(), [&](const trace_entry_t& write) {
+				return write.location == location.location;
+			});
+			present[i] = it != result.writes[i].end();
+			if (present[i]) {
+				written[i] = it->value;
+				snprintf(values[i], sizeof(values[i]), "%06X", it->value);
+			} else {
+				snprintf(values[i], sizeof(values[i]), "-");
+			}
+		}
+		print_location(location, out);
+		fprintf(out, " %-8s %-8s%s\n", values[0], values[1], (present[0] != present[1] || written[0] != written[1]) ? "  <--" : "");
+	}
+
+	fprintf(out, "\n  Registers before the instruction:\n");
+	int column = 0;
+	for (uint32_t reg = 0; reg < TRACE_REG_COUNT; reg++) {
+		if (!result.registers_known[reg]) {
+			continue;
+		}
+		fprintf(out, "  %6s=%06X", trace_reg_name((TraceReg)reg), result.registers[reg]);
+		if (++column == 6) {
+			fputc('\n', out);
+			column = 0;
+		}
+	}
+	if (column) {
+		fputc('\n', out);
+	}
+}
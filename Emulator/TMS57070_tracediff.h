@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TMS57070_trace.h"
+#include "TMS57070_digest.h"
+
+namespace TMS57070 {
+
+	//Where two traces first differ
+	struct trace_divergence_t {
+		bool diverged; //False if the traces are identical
+		uint64_t entry; //Index of the first differing entry
+		uint64_t cycle;
+		bool ended[2]; //Trace ran out of entries at the divergence
+
+		//The instruction the divergence happened in, with the writes it made, for each trace
+		trace_entry_t instruction[2];
+		std::vector<trace_entry_t> writes[2];
+
+		uint32_t registers[TRACE_REG_COUNT]; //Register values before that instruction. Identical in both traces up to there
+		bool registers_known[TRACE_REG_COUNT]; //False for registers the trace has not recorded a value for yet
+	};
+
+	//Where two digest files first differ
+	struct digest_divergence_t {
+		bool diverged; //False if the digests are identical
+		uint64_t sample; //Index of the first differing sample
+		uint64_t cycle[2]; //Cycle at the end of that sample, per run. 0 if the run ended before it
+		bool ended[2]; //Run has no digest for that sample
+	};
+
+	//Finds the first entry at which two traces differ.
+	//Traces are compared in large checkpoint blocks, and the first block that differs is bisected,
+	//so the cost is one sequential read of both files up to the divergence
+	class TraceDiffer {
+	public:
+		static constexpr uint32_t CHECKPOINT_ENTRIES = 1 << 16;
+
+		bool compare(const char* path_a, const char* path_b, trace_divergence_t* result); //False if a trace can't be read
+		static void print(const trace_divergence_t& result, FILE* out);
+
+		//Same for two StateDigest files: the first sample at which the runs' state differs
+		bool compare_digests(const char* path_a, const char* path_b, digest_divergence_t* result);
+		static void print(const digest_divergence_t& result, FILE* out);
+
+	private:
+		static void track_registers(const trace_entry_t* entries, size_t count, trace_divergence_t* result);
+		static uint64_t instruction_start(TraceReader& trace, uint64_t entry); //Last instruction entry at or before entry
+		static void read_instruction(TraceReader& trace, uint64_t start, trace_entry_t* instruction, std::vector<trace_entry_t>* writes);
+	};
+
+}
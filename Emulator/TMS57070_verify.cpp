@@ -0,0 +1,85 @@
+#include "TMS57070_verify.h"
+#include "TMS57070.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace TMS57070;
+
+InstructionVerifier::InstructionVerifier(Emulator& loaded, uint64_t cycle_limit) {
+	base = loaded.fork();
+	base->set_fault_action(FaultAction::Flag); //One bad variant must not take the others down
+	base->register_sample_out_callback(nullptr); //Host callbacks are not expected to be thread-safe
+	this->cycle_limit = cycle_limit;
+}
+
+InstructionVerifier::~InstructionVerifier() = default;
+
+verify_result_t InstructionVerifier::run_one(const verify_variant_t& variant) {
+	std::unique_ptr<Emulator> dsp = base->fork();
+	for (uint32_t i = 0; i < 512; i++) {
+		if (dsp->PMEM[i] == PMEM_INJECT_MAGIC) {
+			dsp->PMEM[i] = variant.inject_word;
+		} else if (i == variant.replacement_pos) {
+			dsp->PMEM[i] = variant.replacement_word;
+		}
+	}
+
+	verify_result_t result = { variant, VerifyStatus::Done, 0, "" };
+	uint64_t start_cycle = dsp->cycles();
+	for (uint32_t i = 0; i < BOOT_STEPS && !dsp->has_faulted(); i++) {
+		dsp->step();
+	}
+	while (dsp->PC.value != END_PC && !dsp->has_faulted()) {
+		if (dsp->cycles() - start_cycle >= cycle_limit) {
+			result.status = VerifyStatus::Timeout;
+			break;
+		}
+		dsp->step();
+	}
+	if (dsp->has_faulted()) {
+		result.status = VerifyStatus::Fault;
+	}
+	result.cycles = dsp->cycles() - start_cycle;
+	result.report = dsp->reportState();
+	return result;
+}
+
+std::vector<verify_result_t> InstructionVerifier::run(const std::vector<verify_variant_t>& variants, unsigned threads) {
+	std::vector<verify_result_t> results(variants.size());
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = (unsigned)std::min<size_t>(threads, variants.size());
+
+	//Workers pull the next variant index, so slow variants don't hold up a fixed share
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]() {
+		for (size_t i = next++; i < variants.size(); i = next++) {
+			results[i] = run_one(variants[i]);
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned i = 1; i < threads; i++) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : pool) {
+		thread.join();
+	}
+	return results;
+}
+
+bool InstructionVerifier::write_results(const char* path, const std::vector<verify_result_t>& results) {
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	static const char* STATUS_NAMES[] = { "done", "fault", "timeout" };
+	for (const verify_result_t& result : results) {
+		fprintf(file, "{\"inject\":\"%08X\",\"replacement\":\"%08X\",\"pos\":\"%X\",\"status\":\"%s\",\"cycles\":%llu,\"state\":%s}\n",
+			result.variant.inject_word, result.variant.replacement_word, result.variant.replacement_pos,
+			STATUS_NAMES[(int)result.status], (unsigned long long)result.cycles, result.report.c_str());
+	}
+	return fclose(file) == 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TMS57070 {
+
+	class Emulator;
+
+	//PMEM words with this value are replaced by the instruction under test
+	constexpr uint32_t PMEM_INJECT_MAGIC = 0xFEEDBEE5;
+
+	//One instruction to verify, as passed to MODE 1 on the command line
+	struct verify_variant_t {
+		uint32_t inject_word; //Replaces every PMEM_INJECT_MAGIC word
+		uint32_t replacement_word; //Replaces the word at replacement_pos
+		uint32_t replacement_pos; //UINT32_MAX for no replacement
+	};
+
+	enum class VerifyStatus {
+		Done, //Reached the end PC
+		Fault, //Unknown instruction or behaviour, or a stack error
+		Timeout, //Did not reach the end PC within the cycle limit
+	};
+
+	struct verify_result_t {
+		verify_variant_t variant;
+		VerifyStatus status;
+		uint64_t cycles;
+		std::string report; //reportState() at the end of the run
+	};
+
+	//Runs many instruction variants of the verification program in one process.
+	//The program is loaded once into a base emulator, which every variant forks from, so each
+	//variant costs only its own run. Results come back in variant order whatever the thread count
+	class InstructionVerifier {
+	public:
+		static constexpr uint32_t BOOT_STEPS = 8; //Scan past RESET before looking for the end PC
+		static constexpr uint32_t END_PC = 0xD; //The verification program idles here when it is done
+		static constexpr uint64_t DEFAULT_CYCLE_LIMIT = 1000000;
+
+		//base: PMEM (still containing PMEM_INJECT_MAGIC words), CMEM, CRs and input samples set up
+		InstructionVerifier(Emulator& base, uint64_t cycle_limit = DEFAULT_CYCLE_LIMIT);
+		~InstructionVerifier();
+
+		verify_result_t run_one(const verify_variant_t& variant);
+		std::vector<verify_result_t> run(const std::vector<verify_variant_t>& variants, unsigned threads = 0); //0: one per hardware thread
+
+		//One JSON object per line, holding the variant, its status and reportState()
+		static bool write_results(const char* path, const std::vector<verify_result_t>& results);
+
+	private:
+		std::unique_ptr<Emulator> base;
+		uint64_t cycle_limit;
+	};
+
+}
@@ -0,0 +1,207 @@
+#include "TMS57070_wcet.h"
+#include "TMS57070.h"
+#include "TMS57070_profile.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TMS57070;
+
+WcetAnalyzer::WcetAnalyzer(const uint32_t program[PMEM_WORDS]) {
+	memcpy(pmem, program, sizeof(pmem));
+}
+
+void WcetAnalyzer::bound(uint16_t pc, uint32_t max) {
+	bounds[pc & 0x1FF] = max;
+}
+
+bool WcetAnalyzer::parse_bounds(const char* spec) {
+	while (*spec) {
+		char* end;
+		uint32_t pc = strtoul(spec, &end, 16);
+		if (end == spec || *end != '=' || pc >= PMEM_WORDS) {
+			return false;
+		}
+		spec = end + 1;
+		uint32_t max = strtoul(spec, &end, 10);
+		if (end == spec || (*end != ',' && *end != '\0')) {
+			return false;
+		}
+		bound((uint16_t)pc, max);
+		spec = (*end == ',') ? end + 1 : end;
+	}
+	return true;
+}
+
+wcet_result_t WcetAnalyzer::analyze(uint16_t entry) {
+	contexts.clear();
+	visits.clear();
+	exits.clear();
+	result = wcet_result_t{ entry, true, 0, 0, "", {} };
+
+	result.cycles = walk(entry, get_context(entry, NO_END, -1, 0));
+
+	std::sort(result.assumed.begin(), result.assumed.end());
+	result.assumed.erase(std::unique(result.assumed.begin(), result.assumed.end()), result.assumed.end());
+	return result;
+}
+
+uint64_t WcetAnalyzer::walk(uint16_t pc, int context) {
+	pc &= 0x1FF;
+	if (!in_region(pc, context)) { //Jumped out of a loop, continued by loop()
+		exits[context].push_back(pc);
+		return 0;
+	}
+
+	uint64_t key = (uint64_t)context << 16 | pc;
+	auto visit = visits.find(key);
+	if (visit != visits.end()) {
+		return visit->second.done ? visit->second.cycles : fail(pc, "loop without a bound");
+	}
+	visits[key] = visit_t{ 0, false };
+
+	uint32_t insn = pmem[pc];
+	uint8_t opcode = insn >> 24;
+	uint16_t next = (pc + 1) & 0x1FF;
+	uint16_t target = insn & 0x1FF;
+	bool region_end = pc == contexts[context].end; //The loop goes back from here
+	uint64_t cycles = 1;
+
+	if (opcode >= 0xF0) {
+		uint8_t args = (insn >> 20) & 0x7C; //As in execJmp()
+		bool is_call = opcode >= 0xF8;
+		bool conditional = args != 0x00;
+		if (args == 0x08 || args == 0x0C) {
+			cycles = fail(pc, "indirect jump");
+		} else if (is_call) {
+			cycles += call(target, context) + (region_end ? 0 : walk(next, context));
+		} else if (region_end) {
+			//The loop's own jump
+		} else if (target == pc && !conditional) {
+			//Idle loop: the handler is done
+		} else if (target <= pc && in_region(target, context)) { //Loop
+			auto bound_entry = bounds.find(pc);
+			if (bound_entry == bounds.end()) {
+				cycles = fail(pc, "backward jump without a bound");
+			} else {
+				cycles += loop(target, pc, bound_entry->second, context, conditional);
+			}
+		} else if (conditional) {
+			cycles += std::max(walk(target, context), walk(next, context));
+		} else {
+			cycles += walk(target, context);
+		}
+	} else if (region_end || opcode == 0xEE) { //RETI ends the handler
+		//Nothing follows
+	} else if (opcode == 0xEC) { //RET
+		if (contexts[context].depth == 0) {
+			cycles = fail(pc, "RET outside a subroutine");
+		}
+	} else if (opcode == 0xE0 || opcode == 0xE2 || opcode == 0xE3) { //RPTK
+		uint32_t repeats = (insn >> 16) & 0xFF;
+		if (opcode != 0xE0) { //By ACC1/ACC2, truncated to the 8 bits of RPTC
+			auto bound_entry = bounds.find(pc);
+			if (bound_entry != bounds.end()) {
+				repeats = std::min<uint32_t>(bound_entry->second, 0xFF);
+			} else {
+				repeats = 0xFF;
+				result.assumed.push_back(pc);
+			}
+		}
+		if ((pmem[next] >> 24) >= 0xE0) {
+			cycles = fail(next, "repeated control instruction");
+		} else {
+			cycles += repeats + 1;
+			if (next != contexts[context].end) {
+				cycles += walk((next + 1) & 0x1FF, context);
+			}
+		}
+	} else if (opcode == 0xE4) { //RPTB
+		uint32_t repeats = (insn >> 16) & 0xFF;
+		if (target == next) { //Not a loop, see execPrimary()
+			cycles += walk(next, context);
+		} else if (target < next) {
+			cycles = fail(pc, "RPTB end before its start");
+		} else if (!in_region(target, context)) {
+			cycles = fail(pc, "RPTB block crosses the end of a loop");
+		} else {
+			cycles += loop(next, target, repeats + 1, context, true);
+		}
+	} else {
+		cycles += walk(next, context);
+	}
+
+	visits[key] = visit_t{ cycles, true };
+	return cycles;
+}
+
+uint64_t WcetAnalyzer::loop(uint16_t start, uint16_t end, uint64_t passes, int context, bool falls_through) {
+	int body_context = get_context(start, end, context, contexts[context].depth);
+	uint64_t body = walk(start, body_context);
+
+	uint64_t after = falls_through ? walk((end + 1) & 0x1FF, context) : 0;
+	for (size_t index = 0; index < exits[body_context].size(); index++) {
+		after = std::max(after, walk(exits[body_context][index], context));
+	}
+	if (!falls_through && exits[body_context].empty()) {
+		return fail(end, "endless loop");
+	}
+	return passes * body + after;
+}
+
+uint64_t WcetAnalyzer::call(uint16_t target, int context) {
+	uint8_t depth = contexts[context].depth + 1;
+	if (depth > Profiler::MAX_DEPTH) {
+		return fail(target, "call stack overflow");
+	}
+	return walk(target, get_context(target, NO_END, -1, depth));
+}
+
+int WcetAnalyzer::get_context(uint16_t start, uint16_t end, int parent, uint8_t depth) {
+	for (size_t index = 0; index < contexts.size(); index++) {
+		const context_t& context = contexts[index];
+		if (context.start == start && context.end == end && context.parent == parent && context.depth == depth) {
+			return (int)index;
+		}
+	}
+	contexts.push_back(context_t{ start, end, parent, depth });
+	exits.emplace_back();
+	return (int)contexts.size() - 1;
+}
+
+bool WcetAnalyzer::in_region(uint16_t pc, int context) const {
+	const context_t& region = contexts[context];
+	return region.end == NO_END || (pc >= region.start && pc <= region.end);
+}
+
+uint64_t WcetAnalyzer::fail(uint16_t pc, const char* problem) {
+	if (result.bounded) {
+		result.bounded = false;
+		result.problem_pc = pc;
+		result.problem = problem;
+	}
+	return 0;
+}
+
+void WcetAnalyzer::print(FILE* out, double budget) {
+	//Reset, then the interrupt vectors in priority order
+	std::vector<uint16_t> entries = { 0 };
+	for (uint32_t flag = 0; flag < 8; flag++) {
+		entries.push_back(Emulator::int_vector_decode((uint8_t)(1 << flag)).PC.value);
+	}
+
+	fprintf(out, "Worst-case cycles, budget %.1f cycles per sample period\n", budget);
+	for (uint16_t entry : entries) {
+		wcet_result_t wcet = analyze(entry);
+		fprintf(out, "%-5s %03X: ", Profiler::vector_name(entry), entry);
+		if (!wcet.bounded) {
+			fprintf(out, "unbounded, %s at %03X\n", wcet.problem.c_str(), wcet.problem_pc);
+			continue;
+		}
+		fprintf(out, "%" PRIu64 " cycles (%.1f%%)%s\n", wcet.cycles, 100.0 * wcet.cycles / budget, (wcet.cycles > budget) ? " OVER BUDGET" : "");
+		for (uint16_t pc : wcet.assumed) {
+			fprintf(out, "      RPTK by ACC at %03X assumed to repeat 255 times\n", pc);
+		}
+	}
+}
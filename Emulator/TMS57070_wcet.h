@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TMS57070 {
+
+	struct wcet_result_t {
+		uint16_t entry; //Vector address
+		bool bounded; //False if a path could not be bounded, see problem
+		uint64_t cycles; //Worst case from the vector to RETI or an idle loop
+		uint16_t problem_pc;
+		std::string problem;
+		std::vector<uint16_t> assumed; //PCs of RPTK by ACC without a bound, assumed to repeat 255 times (RPTC is 8 bits)
+	};
+
+	//Static worst-case cycle count of the interrupt handlers of a PMEM image. Every instruction takes one cycle.
+	//The control-flow graph follows jumps and calls (F0-FF), RPTK (E0, E2, E3) and RPTB (E4) loops, RET and RETI.
+	//A handler ends at RETI or at an idle loop (an unconditional jump to itself).
+	//Repeat counts come from immediates, or for RPTK by ACC1/ACC2 from bounds given per PC. Backward conditional
+	//jumps need a bound too: the number of times they are taken per pass. Indirect jumps cannot be analyzed.
+	//Nested interrupts are not accounted for
+	class WcetAnalyzer {
+	public:
+		static constexpr uint32_t PMEM_WORDS = 512;
+
+		WcetAnalyzer(const uint32_t pmem[PMEM_WORDS]);
+		void bound(uint16_t pc, uint32_t max); //Largest RPTK by ACC count, or times a backward jump is taken, at pc
+		bool parse_bounds(const char* spec); //"pc=max,pc=max", hex PC and decimal count
+
+		wcet_result_t analyze(uint16_t entry);
+		void print(FILE* out, double budget); //Every vector, against a budget of cycles per sample period
+
+	private:
+		struct context_t {
+			uint16_t start; //Loop region, or function entry
+			uint16_t end; //Last instruction of a loop region. NO_END outside loops
+			int parent; //-1 for a handler
+			uint8_t depth; //Call depth
+		};
+		struct visit_t {
+			uint64_t cycles;
+			bool done;
+		};
+		static constexpr uint16_t NO_END = 0xFFFF;
+
+		uint64_t walk(uint16_t pc, int context); //Worst case from pc to the end of the context
+		uint64_t loop(uint16_t start, uint16_t end, uint64_t passes, int context, bool falls_through); //passes more passes of [start, end], then what follows
+		uint64_t call(uint16_t target, int context);
+		int get_context(uint16_t start, uint16_t end, int parent, uint8_t depth);
+		bool in_region(uint16_t pc, int context) const;
+		uint64_t fail(uint16_t pc, const char* problem);
+
+		uint32_t pmem[PMEM_WORDS];
+		std::map<uint16_t, uint32_t> bounds;
+
+		//State of the current analyze()
+		std::vector<context_t> contexts;
+		std::map<uint64_t, visit_t> visits; //context << 16 | pc
+		std::vector<std::vector<uint16_t>> exits; //Per loop context: targets of jumps out of the region
+		wcet_result_t result;
+	};
+
+}
@@ -10,16 +10,23 @@ using namespace std;
 
 #include "TMS57070.h"
 #include "TMS57070_MAC.h"
+#include "TMS57070_verify.h"
+#include "TMS57070_tracediff.h"
+#include "TMS57070_wcet.h"
+#include "TMS57070_response.h"
+#include "TMS57070_shadow.h"
 
 #include "wave/file.h" //https://github.com/audionamix/wave
 
 //Mode 1 is used for my automatic emulation verification process.
 //Mode 2 is the normal mode where there is an input WAV file and output WAV
+//Mode 3 runs every line of variants.txt ("inject_word [replacement_word replacement_pos]", hex) through mode 1's program in one process
 #define MODE 2
 
 constexpr uint32_t PMEM_MAX_WORDS = 0x1FF;
 constexpr uint32_t CMEM_MAX_WORDS = 0x1FF;
-constexpr uint32_t PMEM_INJECT_MAGIC = 0xFEEDBEE5; //used for my automatic emulation verification process.
+using TMS57070::PMEM_INJECT_MAGIC; //used for my automatic emulation verification process.
+constexpr uint32_t DSP_CLOCK_HZ = TMS57070::DEFAULT_DSP_CLOCK_HZ; //Instruction clock of the emulated device
 
 TMS57070::Emulator dsp;
 
@@ -57,7 +64,75 @@ void dsp_ext_io_out(int32_t value, uint32_t address) {
     printf("External IO output: %X address: %X\n", value, address);
 }
 
+//Logs every breakpoint and watchpoint hit without stopping
+static bool dsp_debug_hit(const TMS57070::debug_hit_t& hit, void* /*context*/) {
+    static const char* MEMORY_NAMES[] = { "", "CMEM", "DMEM", "XMEM" };
+    if (hit.watchpoint) {
+        printf("Instruction at %X %s %s %X\n", hit.pc, hit.access == TMS57070::WatchKind::Write ? "wrote" : "read", MEMORY_NAMES[(int)hit.target], hit.addr);
+    } else {
+        printf("Breakpoint at %X, cycle %llu\n", hit.pc, (unsigned long long)hit.cycle);
+    }
+    return false;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--print-trace") == 0) {
+        //Decode a trace file recorded with TMS57070_TRACE set
+        TMS57070::TraceReader trace;
+        if (!trace.open(argv[2])) {
+            printf("Could not open trace %s\n", argv[2]);
+            return 1;
+        }
+        trace.print(stdout);
+        return 0;
+    }
+    if (argc == 4 && strcmp(argv[1], "--diff-trace") == 0) {
+        //Report the first instruction at which two traces differ
+        TMS57070::TraceDiffer differ;
+        TMS57070::trace_divergence_t divergence;
+        if (!differ.compare(argv[2], argv[3], &divergence)) {
+            printf("Could not open traces %s and %s\n", argv[2], argv[3]);
+            return 1;
+        }
+        TMS57070::TraceDiffer::print(divergence, stdout);
+        return divergence.diverged ? 2 : 0;
+    }
+    if (argc == 4 && strcmp(argv[1], "--diff-digest") == 0) {
+        //Report the first sample at which two digest files differ
+        TMS57070::TraceDiffer differ;
+        TMS57070::digest_divergence_t divergence;
+        if (!differ.compare_digests(argv[2], argv[3], &divergence)) {
+            printf("Could not open digests %s and %s\n", argv[2], argv[3]);
+            return 1;
+        }
+        TMS57070::TraceDiffer::print(divergence, stdout);
+        return divergence.diverged ? 2 : 0;
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--wcet") == 0) {
+        //Worst-case cycles of each interrupt handler of a PMEM image, without running it.
+        //Optional bounds: "pc=max,..." for RPTK by ACC and backward jumps, PC in hex
+        uint32_t pmem[TMS57070::WcetAnalyzer::PMEM_WORDS] = {};
+        ifstream PMEMFile(argv[2], std::ios::binary);
+        uint32_t pmem_length = std::min(ifstream_length(&PMEMFile) / 4, TMS57070::WcetAnalyzer::PMEM_WORDS);
+        if (pmem_length == 0) {
+            printf("Could not read PMEM %s\n", argv[2]);
+            return 1;
+        }
+        uint8_t readBuffer[4];
+        for (uint32_t i = 0; i < pmem_length; i++) {
+            PMEMFile.read((char*)readBuffer, 4);
+            pmem[i] = readBuffer[0] << 24 | readBuffer[1] << 16 | readBuffer[2] << 8 | readBuffer[3];
+        }
+
+        TMS57070::WcetAnalyzer analyzer(pmem);
+        if (argc == 4 && !analyzer.parse_bounds(argv[3])) {
+            printf("Could not parse bounds %s\n", argv[3]);
+            return 1;
+        }
+        analyzer.print(stdout, (double)DSP_CLOCK_HZ / TMS57070::DEFAULT_SAMPLE_RATE);
+        return 0;
+    }
+
     uint32_t inject_word = 0;
     uint32_t replacement_word = 0;
     uint32_t replacement_pos = UINT32_MAX;
@@ -79,6 +154,85 @@ int main(int argc, char* argv[]) {
     dsp.register_external_bus_in_callback(dsp_ext_io_in);
     dsp.register_external_bus_out_callback(dsp_ext_io_out);
 
+    //Set TMS57070_TRACE to a file path to record an instruction trace of the whole run
+    TMS57070::TraceRecorder tracer;
+    const char* trace_path = getenv("TMS57070_TRACE");
+    if (trace_path) {
+        if (tracer.open(trace_path)) {
+            dsp.set_tracer(&tracer);
+        } else {
+            printf("Could not open trace file %s\n", trace_path);
+        }
+    }
+
+    //Set TMS57070_PROFILE to a file path to write an annotated listing of where the cycles went,
+    //and folded call stacks for flame graph tools next to it (path + ".folded")
+    TMS57070::Profiler profiler;
+    const char* profile_path = getenv("TMS57070_PROFILE");
+    if (profile_path) {
+        dsp.set_profiler(&profiler);
+    }
+
+    //Set TMS57070_COVERAGE to a file path to write which opcodes and addressing modes the run executed
+    TMS57070::Coverage coverage;
+    const char* coverage_path = getenv("TMS57070_COVERAGE");
+    if (coverage_path) {
+        dsp.set_coverage(&coverage);
+    }
+
+    //Set TMS57070_OVERFLOW to print how often the program saturated, overflowed and clipped
+    TMS57070::OverflowCounters overflow;
+    bool count_overflow = getenv("TMS57070_OVERFLOW") != nullptr;
+    if (count_overflow) {
+        dsp.set_overflow_counters(&overflow);
+    }
+
+    //Set TMS57070_HEATMAP to a CSV path to count memory reads and writes per word, and print the working sets
+    TMS57070::AccessHeatmap heatmap;
+    const char* heatmap_path = getenv("TMS57070_HEATMAP");
+    if (heatmap_path) {
+        dsp.set_heatmap(&heatmap);
+    }
+
+    //Set TMS57070_BREAK to hex PCs ("3D,40") and TMS57070_WATCH to memory words ("CMEM:38,DMEM:1F0") to log
+    //every time they execute or are accessed
+    TMS57070::Debugger debugger;
+    const char* break_spec = getenv("TMS57070_BREAK");
+    const char* watch_spec = getenv("TMS57070_WATCH");
+    if (break_spec || watch_spec) {
+        for (const char* pc = break_spec; pc && *pc; ) {
+            char* end;
+            uint32_t address = strtoul(pc, &end, 16);
+            if (end == pc) {
+                printf("Could not parse breakpoints %s\n", break_spec);
+                break;
+            }
+            debugger.add_breakpoint((uint16_t)address);
+            pc = (*end == ',') ? end + 1 : end;
+        }
+        TMS57070::ProbeSet watches; //Same syntax as the probes
+        if (watch_spec && !watches.parse(watch_spec)) {
+            printf("Could not parse watchpoints %s\n", watch_spec);
+        }
+        for (size_t index = 0; index < watches.count(); index++) {
+            if (watches.probe(index).target != TMS57070::TraceTarget::Register) {
+                debugger.add_watchpoint(watches.probe(index).target, watches.probe(index).addr, TMS57070::WatchKind::Access);
+            }
+        }
+        debugger.set_callback(dsp_debug_hit, nullptr);
+        dsp.set_debugger(&debugger);
+    }
+
+    //Set TMS57070_LEAN to run the core that skips unknown instructions and behaviour instead of faulting
+    if (getenv("TMS57070_LEAN")) {
+        dsp.set_core(TMS57070::CoreKind::Lean);
+    }
+
+    //Set TMS57070_SHADOW to check the render against the reference step() interpreter every that many cycles,
+    //or at the end of every sample period if 0. Rendering stops at the first mismatch, which is printed
+    const char* shadow_spec = getenv("TMS57070_SHADOW");
+    std::unique_ptr<TMS57070::ShadowRunner> shadow;
+
 #if MODE == 2
     //Load dsp.PMEM
     ifstream PMEMFile("D:/Documents/OneDrive/Documents/Digitech XP/Emulator/PMEM_XP100.bin", std::ios::binary);
@@ -127,27 +281,118 @@ int main(int argc, char* argv[]) {
     uint32_t sample_rate = read_file.sample_rate();
     printf("Read input WAV\n");
 
+    //Cycles per sample follow from the instruction clock and the WAV sample rate, and may be fractional
+    dsp.set_clock({ DSP_CLOCK_HZ, sample_rate, sample_rate });
+
+    //Set TMS57070_DIGEST to a file path to record a state digest of every sample, for --diff-digest
+    TMS57070::StateDigest digest;
+    const char* digest_path = getenv("TMS57070_DIGEST");
+    if (digest_path) {
+        if (digest.open(digest_path)) {
+            dsp.set_digest(&digest); //After loading memory, which does not go through the emulator
+        } else {
+            printf("Could not open digest file %s\n", digest_path);
+        }
+    }
+
+    //Set TMS57070_HEADROOM to a WAV path to measure the cycles used per sample period.
+    //The WAV holds one value per sample: cycles used / cycles available
+    TMS57070::HeadroomMeter headroom;
+    const char* headroom_path = getenv("TMS57070_HEADROOM");
+    if (headroom_path) {
+        dsp.set_headroom_meter(&headroom);
+    }
+
+    //Set TMS57070_COLUMNS to a file path to record registers every sample in a column file.
+    //TMS57070_COLUMN_REGISTERS picks them, e.g. "ACC1,ACC2,MAC1,MAC2,CA,DA,CR1". The default is all registers
+    TMS57070::ColumnRecorder columns;
+    const char* columns_path = getenv("TMS57070_COLUMNS");
+    if (columns_path) {
+        std::vector<TMS57070::TraceReg> column_registers;
+        const char* column_spec = getenv("TMS57070_COLUMN_REGISTERS");
+        if (!column_spec) {
+            for (uint32_t reg = 0; reg < TMS57070::TRACE_REG_COUNT; reg++) {
+                column_registers.push_back((TMS57070::TraceReg)reg);
+            }
+        }
+        if (column_spec && !TMS57070::parse_trace_regs(column_spec, column_registers)) {
+            printf("Could not parse column registers %s\n", column_spec);
+        } else if (columns.open(columns_path, column_registers)) {
+            dsp.set_column_recorder(&columns);
+        } else {
+            printf("Could not open column file %s\n", columns_path);
+        }
+    }
+
+    //Set TMS57070_PROBES to a list of words and registers to capture every sample, e.g. "CMEM:0C,CMEM:0F,DMEM:1F0,ACC1".
+    //They are written to probes.wav, next to the output in channel 0, and to probes.t57p at full precision
+    TMS57070::ProbeSet probes;
+    const char* probe_spec = getenv("TMS57070_PROBES");
+    if (probe_spec) {
+        if (probes.parse(probe_spec)) {
+            probes.reserve(inSamples.size());
+            dsp.set_probes(&probes);
+        } else {
+            printf("Could not parse probes %s\n", probe_spec);
+        }
+    }
+
     dsp.step();
     dsp.step();
     dsp.step();
+    dsp.start_sample_clocks(); //Sample periods are counted from here
+
+    //Set TMS57070_RESPONSE to a path prefix to measure the latency and the impulse and frequency responses of in_1L,
+    //with the XP pedal input held, before rendering. Writes prefix.impulse.csv and prefix.frequency.csv
+    const char* response_path = getenv("TMS57070_RESPONSE");
+    if (response_path) {
+        TMS57070::ResponseMeter meter({ TMS57070::AudioPort::ARI1, sample_rate, 8192, { 0, 0x450000 } });
+        std::vector<TMS57070::response_t> responses = meter.measure(dsp, { TMS57070::Channel::in_1L });
+        meter.print(responses, stdout);
+
+        std::string impulse_path = std::string(response_path) + ".impulse.csv";
+        std::string frequency_path = std::string(response_path) + ".frequency.csv";
+        FILE* impulse_file = fopen(impulse_path.c_str(), "w");
+        FILE* frequency_file = fopen(frequency_path.c_str(), "w");
+        bool written = impulse_file && frequency_file && meter.write_impulses(responses, impulse_file) && meter.write_frequency_responses(responses, frequency_file);
+        if (impulse_file) {
+            written = fclose(impulse_file) == 0 && written;
+        }
+        if (frequency_file) {
+            written = fclose(frequency_file) == 0 && written;
+        }
+        if (!written) {
+            printf("Could not write responses %s\n", response_path);
+        }
+    }
+    if (shadow_spec) { //After the setup steps, so that both emulators start from the same state
+        shadow = std::make_unique<TMS57070::ShadowRunner>(dsp, strtoull(shadow_spec, nullptr, 0));
+    }
+
     for (uint32_t i = 0; i < inSamples.size(); i++) { //sample_rate * 10
-        dsp.sample_in(TMS57070::Channel::in_1L, (int32_t)(inSamples[i] * 0x7FFFFF));
-        dsp.sample_in(TMS57070::Channel::in_1R, 0x450000); //Digitech XP series pedal input
-        //dsp.sample_in(TMS57070::Channel::in_1R, 0x150000 + ((uint64_t)0x300000 * i) / (uint64_t)(sample_rate * 10)); //Vary pedal input over 10 seconds
-        for (uint32_t i = 0; i < 512; i++) {
-            dsp.step();
+        if (shadow) {
+            shadow->sample_in(TMS57070::Channel::in_1L, (int32_t)(inSamples[i] * 0x7FFFFF));
+            shadow->sample_in(TMS57070::Channel::in_1R, 0x450000);
+            if (!shadow->run_sample_period(TMS57070::AudioPort::ARI1)) {
+                break;
+            }
+        } else {
+            dsp.sample_in(TMS57070::Channel::in_1L, (int32_t)(inSamples[i] * 0x7FFFFF));
+            dsp.sample_in(TMS57070::Channel::in_1R, 0x450000); //Digitech XP series pedal input
+            //dsp.sample_in(TMS57070::Channel::in_1R, 0x150000 + ((uint64_t)0x300000 * i) / (uint64_t)(sample_rate * 10)); //Vary pedal input over 10 seconds
+            dsp.run_sample_period(TMS57070::AudioPort::ARI1);
         }
 
         if (i % sample_rate == 0) {
             printf("%d seconds\n", i/sample_rate);
         }
 
-        //Optionally print out some Digitech XP series values
+        //Optionally print out some Digitech XP series values. TMS57070_PROBES=CMEM:0C,CMEM:0F,CMEM:10,CMEM:11,CMEM:12 records them without printing
         //printf("0C %X 0F %X 10 %X 11 %X 12 %X \n", dsp.CMEM[0x0C].value, dsp.CMEM[0x0F].value, dsp.CMEM[0x10].value, dsp.CMEM[0x11].value, dsp.CMEM[0x12].value);
 
         //Optionally print out a dump of all registers, CMEM, and DMEM
-        //std::string report = dsp.reportState();
-        //std::cout << report << "\r";
+        //dsp.write_state_json(stdout);
+        //printf("\r");
     }
 
     wave::File write_file;
@@ -166,6 +411,52 @@ int main(int argc, char* argv[]) {
         return 4;
     }
 
+    if (headroom_path) {
+        headroom.print(stdout);
+        wave::File headroom_file;
+        err = headroom_file.Open(headroom_path, wave::kOut);
+        if (!err) {
+            headroom_file.set_sample_rate(sample_rate);
+            headroom_file.set_bits_per_sample(16);
+            headroom_file.set_channel_number(1);
+            err = headroom_file.Write(headroom.loads());
+        }
+        if (err) {
+            printf("Could not write headroom WAV %s\n", headroom_path);
+        }
+    }
+
+    if (columns_path && !columns.close()) {
+        printf("Could not write column file %s\n", columns_path);
+    }
+
+    if (probes.count()) {
+        size_t channels = probes.count() + 1;
+        size_t frames = std::min(probes.frames(), outSamples.size());
+        std::vector<float> probeSamples(frames * channels);
+        for (size_t frame = 0; frame < frames; frame++) {
+            probeSamples[frame * channels] = outSamples[frame];
+        }
+        for (size_t index = 0; index < probes.count(); index++) {
+            std::vector<float> channel = probes.channel(index);
+            for (size_t frame = 0; frame < frames; frame++) {
+                probeSamples[frame * channels + index + 1] = channel[frame];
+            }
+        }
+
+        wave::File probe_file;
+        err = probe_file.Open("probes.wav", wave::kOut);
+        if (!err) {
+            probe_file.set_sample_rate(sample_rate);
+            probe_file.set_bits_per_sample(read_file.bits_per_sample());
+            probe_file.set_channel_number((uint16_t)channels);
+            err = probe_file.Write(probeSamples);
+        }
+        if (err || !probes.write("probes.t57p")) {
+            printf("Could not write probes\n");
+        }
+    }
+
     //Build state string
     std::string report = dsp.reportState();
     //std::cout << report;
@@ -173,6 +464,54 @@ int main(int argc, char* argv[]) {
     ofstream reportFile("report.txt", std::ios::binary);
     reportFile.write(report.c_str(), report.size());
     reportFile.close();
+#elif MODE == 3
+    //Load dsp.PMEM as is: the verifier injects each variant into its own fork
+    ifstream PMEMFile("D:/Documents/OneDrive/Documents/Digitech XP/Emulator/PMEM.bin", std::ios::binary);
+    ifstream CMEMFile("D:/Documents/OneDrive/Documents/Digitech XP/Emulator/CMEM.bin", std::ios::binary);
+
+    uint32_t pmem_length = ifstream_length(&PMEMFile);
+    uint32_t cmem_length = ifstream_length(&CMEMFile);
+    pmem_length = std::min(pmem_length / 4, PMEM_MAX_WORDS);
+    cmem_length = std::min(cmem_length / 3, CMEM_MAX_WORDS);
+
+    uint8_t readBuffer[4];
+    for (uint32_t i = 0; i < pmem_length; i++) {
+        PMEMFile.read((char*)readBuffer, 4);
+        dsp.PMEM[i] = readBuffer[0] << 24 | readBuffer[1] << 16 | readBuffer[2] << 8 | readBuffer[3];
+    }
+
+    for (uint32_t i = 0; i < cmem_length; i++) {
+        CMEMFile.read((char*)readBuffer, 3);
+        uint32_t word = readBuffer[0] << 16 | readBuffer[1] << 8 | readBuffer[2];
+        dsp.CMEM[i].value = word;
+    }
+
+    dsp.CR0.value = 0xAA9BAD;
+    dsp.CR1.value = 0x890100;
+    dsp.CR2.value = 0x30FF00;
+    dsp.CR3.value = 0xE68000;
+
+    dsp.sample_in(TMS57070::Channel::in_1L, 0);
+    dsp.sample_in(TMS57070::Channel::in_1R, 0); //Triggers test
+
+    std::vector<TMS57070::verify_variant_t> variants;
+    ifstream variantsFile("variants.txt");
+    std::string line;
+    while (std::getline(variantsFile, line)) {
+        TMS57070::verify_variant_t variant = { 0, 0, UINT32_MAX };
+        int fields = sscanf(line.c_str(), "%x %x %x", &variant.inject_word, &variant.replacement_word, &variant.replacement_pos);
+        if (fields == 1 || fields == 3) {
+            variants.push_back(variant);
+        }
+    }
+    printf("Verifying %zu variants\n", variants.size());
+
+    TMS57070::InstructionVerifier verifier(dsp);
+    std::vector<TMS57070::verify_result_t> results = verifier.run(variants);
+    if (!TMS57070::InstructionVerifier::write_results("verify_results.txt", results)) {
+        printf("Could not write verify_results.txt\n");
+        return 1;
+    }
 #else
     //Load dsp.PMEM
     ifstream PMEMFile("D:/Documents/OneDrive/Documents/Digitech XP/Emulator/PMEM.bin", std::ios::binary);
@@ -216,8 +555,7 @@ int main(int argc, char* argv[]) {
     while (dsp.PC.value != 0xD) { //Wait for program to be done
         dsp.step();
 
-        //std::string report = dsp.reportState();
-        //std::cout << report;
+        //dsp.write_state_json(stdout);
     }
 
     //Build state string
@@ -229,5 +567,55 @@ int main(int argc, char* argv[]) {
     reportFile.close();
 
 #endif
+
+    if (trace_path && !tracer.close()) {
+        printf("Could not write trace file %s\n", trace_path);
+    }
+    if (profile_path) {
+        FILE* listing = fopen(profile_path, "w");
+        std::string folded_path = std::string(profile_path) + ".folded";
+        FILE* folded = fopen(folded_path.c_str(), "w");
+        if (listing && folded) {
+            profiler.print_listing(dsp.PMEM, listing);
+            profiler.write_folded(dsp.PMEM, folded);
+        } else {
+            printf("Could not write profile %s\n", profile_path);
+        }
+        if (listing) {
+            fclose(listing);
+        }
+        if (folded) {
+            fclose(folded);
+        }
+    }
+    if (count_overflow) {
+        overflow.print(stdout);
+    }
+    if (coverage_path) {
+        FILE* coverage_file = fopen(coverage_path, "w");
+        if (coverage_file) {
+            coverage.print(coverage_file);
+            fclose(coverage_file);
+        } else {
+            printf("Could not write coverage %s\n", coverage_path);
+        }
+    }
+    if (heatmap_path) {
+        heatmap.print(stdout);
+        FILE* heatmap_file = fopen(heatmap_path, "w");
+        bool written = heatmap_file && heatmap.write_heatmap(heatmap_file);
+        if (heatmap_file) {
+            written = fclose(heatmap_file) == 0 && written;
+        }
+        if (!written) {
+            printf("Could not write heatmap %s\n", heatmap_path);
+        }
+    }
+    if (shadow) {
+        shadow->print(stdout);
+        if (shadow->diverged()) {
+            return 2;
+        }
+    }
     return 0;
 }